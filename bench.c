@@ -0,0 +1,581 @@
+/*
+ *  bench.c
+ *
+ *  Entry point of the benchmarks,
+ *  extends 'bench.h'.
+ *
+ */
+
+#include "bench.h"
+
+
+/* Current time in nanoseconds. */
+static uint64_t _bench_now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Order of the times, for qsort. */
+static int _bench_cmp(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *) a;
+    const uint64_t y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/* First numbered tile of a grid. */
+static bool _bench_number(const grid_t *grid, size_t *x, size_t *y)
+{
+    for(size_t i = 0; i < grid->rows * grid->cols; ++i)
+    {
+        const lo_layer_t lo = tile_lo(grid->tiles[i]);
+
+        if(lo != D0 && lo != MINE)
+        {
+            *x = i % grid->cols;
+            *y = i / grid->cols;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Empty tile of the largest opening. */
+static bool _bench_opening(grid_t *grid, size_t *x, size_t *y)
+{
+    size_t best = 0, best_size = 0;
+
+    for(size_t i = 0; i < grid_openings(grid); ++i)
+    {
+        if(grid_opening_size(grid, i) > best_size)
+        {
+            best = i;
+            best_size = grid_opening_size(grid, i);
+        }
+    }
+
+    if(best_size == 0)
+        return false;
+
+    /* An opening's list starts with its empty tile */
+    const size_t pos = grid->open_tiles[grid->open_start[best]];
+
+    *x = pos % grid->cols;
+    *y = pos / grid->cols;
+    return true;
+}
+
+/* Case: new_grid. */
+static uint64_t _bench_new_grid(const bench_size_t *size, uint64_t seed)
+{
+    const uint64_t start = _bench_now();
+    grid_t *grid = new_grid(size->rows, size->cols, size->mines, seed);
+    const uint64_t end = _bench_now();
+
+    if(! grid)
+        return BENCH_SKIP;
+
+    del_grid(grid);
+    return end - start;
+}
+
+/* Case: complete_grid of a made grid. */
+static uint64_t _bench_complete_grid(const bench_size_t *size, uint64_t seed)
+{
+    grid_t *grid = new_grid(size->rows, size->cols, size->mines, seed);
+    if(! grid)
+        return BENCH_SKIP;
+
+    const uint64_t start = _bench_now();
+    complete_grid(grid);
+    const uint64_t end = _bench_now();
+
+    del_grid(grid);
+    return end - start;
+}
+
+/* Case: grid_reveal of a numbered tile. */
+static uint64_t _bench_reveal_tile(const bench_size_t *size, uint64_t seed)
+{
+    grid_t *grid = new_grid(size->rows, size->cols, size->mines, seed);
+    size_t x, y;
+
+    if(! grid || ! _bench_number(grid, &x, &y))
+    {
+        del_grid(grid);
+        return BENCH_SKIP;
+    }
+
+    const uint64_t start = _bench_now();
+    grid_reveal(grid, x, y);
+    const uint64_t end = _bench_now();
+
+    del_grid(grid);
+    return end - start;
+}
+
+/* Case: grid_reveal of the largest opening. */
+static uint64_t _bench_reveal_opening(const bench_size_t *size, uint64_t seed)
+{
+    grid_t *grid = new_grid(size->rows, size->cols, size->mines, seed);
+    size_t x, y;
+
+    if(! grid || ! _bench_opening(grid, &x, &y))
+    {
+        del_grid(grid);
+        return BENCH_SKIP;
+    }
+
+    const uint64_t start = _bench_now();
+    grid_reveal(grid, x, y);
+    const uint64_t end = _bench_now();
+
+    del_grid(grid);
+    return end - start;
+}
+
+/* Case: grid_reveal of a mine, after a safe
+ * move (the 1st move never hits one). */
+static uint64_t _bench_reveal_mine(const bench_size_t *size, uint64_t seed)
+{
+    grid_t *grid = new_grid(size->rows, size->cols, size->mines, seed);
+    size_t x, y;
+
+    if(! grid || size->mines == 0 || ! _bench_number(grid, &x, &y))
+    {
+        del_grid(grid);
+        return BENCH_SKIP;
+    }
+
+    grid_reveal(grid, x, y);
+
+    size_t pos = 0;
+    while(tile_lo(grid->tiles[pos]) != MINE)
+        ++pos;
+
+    const uint64_t start = _bench_now();
+    grid_reveal(grid, pos % grid->cols, pos / grid->cols);
+    const uint64_t end = _bench_now();
+
+    del_grid(grid);
+    return end - start;
+}
+
+/* Case: grid_load of a text or binary board. */
+static uint64_t _bench_load(const bench_size_t *size, uint64_t seed, bool binary)
+{
+    const char *filename = binary ? BENCH_FILE_BIN : BENCH_FILE_TEXT;
+
+    grid_t *grid = new_grid(size->rows, size->cols, size->mines, seed);
+    if(! grid)
+        return BENCH_SKIP;
+
+    const int saved = binary ? grid_save(grid, filename) : grid_save_text(grid, filename);
+    del_grid(grid);
+
+    if(saved != EXIT_SUCCESS)
+        return BENCH_SKIP;
+
+    const uint64_t start = _bench_now();
+    grid = grid_load(filename, NULL);
+    const uint64_t end = _bench_now();
+
+    if(! grid)
+        return BENCH_SKIP;
+
+    del_grid(grid);
+    return end - start;
+}
+
+/* Case: grid_load of a text board. */
+static uint64_t _bench_load_text(const bench_size_t *size, uint64_t seed)
+{
+    return _bench_load(size, seed, false);
+}
+
+/* Case: grid_load of a binary board. */
+static uint64_t _bench_load_bin(const bench_size_t *size, uint64_t seed)
+{
+    return _bench_load(size, seed, true);
+}
+
+/* Case: del_grid. */
+static uint64_t _bench_del_grid(const bench_size_t *size, uint64_t seed)
+{
+    grid_t *grid = new_grid(size->rows, size->cols, size->mines, seed);
+    if(! grid)
+        return BENCH_SKIP;
+
+    const uint64_t start = _bench_now();
+    del_grid(grid);
+
+    return _bench_now() - start;
+}
+
+/* Known cases */
+static const bench_case_t g_cases[] =
+{
+    { "new_grid",            _bench_new_grid },
+    { "complete_grid",       _bench_complete_grid },
+    { "grid_reveal/tile",    _bench_reveal_tile },
+    { "grid_reveal/opening", _bench_reveal_opening },
+    { "grid_reveal/mine",    _bench_reveal_mine },
+    { "grid_load/text",      _bench_load_text },
+    { "grid_load/binary",    _bench_load_bin },
+    { "del_grid",            _bench_del_grid },
+};
+
+/* Sizes: the game's, then big custom ones */
+static const bench_size_t g_sizes[] =
+{
+    { "L", 9, 9, 10 },
+    { "N", 16, 16, 40 },
+    { "T", 16, 30, 99 },
+    { "D", 1000, 1000, 150000 },
+    { "O", 2000, 2000, 600000 },
+};
+
+
+/* Runs a case on one size.
+ *
+ *  test    - the case
+ *  size    - the board size
+ *  seed    - seed of the 1st board
+ *  warmup  - untimed repetitions
+ *  reps    - most timed repetitions
+ *  result  - the timings
+ *
+ * Returns 0 if succeeded, 1 if out of memory
+ * or no board was fit for the case.
+ */
+int bench_run(const bench_case_t *test, const bench_size_t *size, uint64_t seed,
+              size_t warmup, size_t reps, bench_result_t *result)
+{
+    /* Pointer checking */
+    assert(test && size && result);
+
+    memset(result, 0, sizeof(bench_result_t));
+    result->name = test->name;
+    result->size = size;
+
+    if(reps == 0)
+        return EXIT_FAILURE;
+
+    uint64_t *times = (uint64_t *) malloc(sizeof(uint64_t) * reps);
+    if(! times)
+        return EXIT_FAILURE;
+
+    for(size_t i = 0; i < warmup; ++i)
+        test->call(size, seed + i);
+
+    /* Each board once, until the budget is spent */
+    const uint64_t budget = (uint64_t) (BENCH_BUDGET_S * 1e9);
+    const uint64_t start = _bench_now();
+    size_t count = 0;
+
+    for(size_t i = 0; i < reps; ++i)
+    {
+        const uint64_t ns = test->call(size, seed + i);
+
+        if(ns == BENCH_SKIP)
+            ++result->skipped;
+        else
+            times[count++] = ns;
+
+        if(count >= BENCH_REPS_MIN && _bench_now() - start > budget)
+            break;
+    }
+
+    if(count == 0)
+    {
+        free(times);
+        return EXIT_FAILURE;
+    }
+
+    qsort(times, count, sizeof(uint64_t), _bench_cmp);
+
+    double sum = 0;
+    for(size_t i = 0; i < count; ++i)
+        sum += (double) times[i];
+
+    /* Nearest rank */
+    result->reps = count;
+    result->min = times[0];
+    result->median = times[(count - 1) / 2];
+    result->p99 = times[(count * 99 + 99) / 100 - 1];
+    result->max = times[count - 1];
+    result->mean = sum / (double) count;
+
+    free(times);
+    return EXIT_SUCCESS;
+}
+
+/* Writes the timings as JSON.
+ *
+ *  file    - the output
+ *  results - the timings
+ *  count   - no. of the timings
+ *  seed    - seed of the run
+ */
+void bench_json(FILE *file, const bench_result_t *results, size_t count, uint64_t seed)
+{
+    /* Pointer checking */
+    assert(file && (results || count == 0));
+
+    fprintf(file, "{\n  \"seed\": %llu,\n  \"results\": [\n", (unsigned long long) seed);
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        const bench_result_t *r = &results[i];
+
+        fprintf(file, "    { \"case\": \"%s\", \"size\": \"%s\", \"rows\": %zu, \"cols\": %zu, \"mines\": %zu, "
+                      "\"reps\": %zu, \"skipped\": %zu, \"min_ns\": %llu, \"median_ns\": %llu, "
+                      "\"p99_ns\": %llu, \"max_ns\": %llu, \"mean_ns\": %.1f }%s\n",
+                r->name, r->size->name, r->size->rows, r->size->cols, r->size->mines,
+                r->reps, r->skipped, (unsigned long long) r->min, (unsigned long long) r->median,
+                (unsigned long long) r->p99, (unsigned long long) r->max, r->mean,
+                (i + 1 < count) ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+}
+
+/* Spoils the counts of a grid, the mines
+ * stay: a tile a box sum misses keeps a
+ * value no box sum gives.
+ */
+static void _bench_spoil(grid_t *grid)
+{
+    for(size_t i = 0; i < grid->rows * grid->cols; ++i)
+        if(tile_lo(grid->tiles[i]) != MINE)
+            tile_set_lo(&grid->tiles[i], (lo_layer_t) TILE_LO_MASK);
+}
+
+/* Checks the SSE2/AVX2 box sums of
+ * complete_grid against the scalar one, on
+ * 1xN and Nx1 boards and on widths that
+ * leave a rest after 16 or 32 tiles, from
+ * no mines to all tiles but one.
+ *
+ *  out     - where the mismatches go
+ *  seed    - seed of the 1st board
+ *
+ * Returns 0 if all the boards match, 1 if
+ * one does not or out of memory.
+ */
+int bench_check(FILE *out, uint64_t seed)
+{
+    /* Pointer checking */
+    assert(out);
+
+    /* Rows and columns: 1, around 16 and 32 */
+    static const size_t dims[] = { 1, 2, 3, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 100, 130 };
+    const size_t ndims = sizeof(dims) / sizeof(dims[0]);
+
+    size_t checked[GRID_KERNEL_AVX2 + 1] = {0, };
+    size_t failed = 0;
+
+    for(size_t r = 0; r < ndims; ++r)
+    {
+        for(size_t c = 0; c < ndims; ++c)
+        {
+            const size_t size = dims[r] * dims[c];
+            const size_t fills[] = { 0, size * 15 / 100, size / 2, size - 1 };
+
+            for(size_t f = 0; f < sizeof(fills) / sizeof(fills[0]); ++f)
+            {
+                grid_t *grid = new_grid(dims[r], dims[c], fills[f], seed++);
+                tile_t *expected = (tile_t *) malloc(sizeof(tile_t) * size);
+
+                if(grid)
+                    _bench_spoil(grid);
+
+                if(! grid || ! expected || _grid_complete_with(grid, GRID_KERNEL_SCALAR) != EXIT_SUCCESS)
+                {
+                    fprintf(stderr, "Brak pamieci.\n");
+                    free(expected);
+                    del_grid(grid);
+                    return EXIT_FAILURE;
+                }
+
+                memcpy(expected, grid->tiles, sizeof(tile_t) * size);
+
+                for(int k = GRID_KERNEL_SSE2; k <= GRID_KERNEL_AVX2; ++k)
+                {
+                    _bench_spoil(grid);
+
+                    /* Not in the build or the CPU */
+                    if(_grid_complete_with(grid, k) != EXIT_SUCCESS)
+                        continue;
+
+                    ++checked[k];
+
+                    if(memcmp(expected, grid->tiles, sizeof(tile_t) * size) != 0)
+                    {
+                        fprintf(out, "%s %zux%zu/%zu: inne pola niz skalarnie\n",
+                                (k == GRID_KERNEL_SSE2) ? "SSE2" : "AVX2", dims[r], dims[c], fills[f]);
+                        ++failed;
+                    }
+                }
+
+                free(expected);
+                del_grid(grid);
+            }
+        }
+    }
+
+    fprintf(out, "SSE2: %zu plansz, AVX2: %zu plansz, niezgodnych: %zu\n",
+            checked[GRID_KERNEL_SSE2], checked[GRID_KERNEL_AVX2], failed);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* Displays help. */
+void help(void)
+{
+    printf("\n Uzycie:\n\n\t./saper-bench.out <opcjonalne flagi>\n\n");
+    printf(" Flagi:\n\n");
+    printf(" h            - wyswietla pomoc\n"
+           " n <ilosc>    - najwiecej powtorzen (domyslnie %d)\n"
+           " w <ilosc>    - powtorzen na rozgrzewke (domyslnie %d)\n"
+           " p <rozmiary> - rozmiary, np. LTD (domyslnie LNTDO)\n"
+           " c <nazwa>    - tylko przypadki zaczynajace sie od nazwy\n"
+           " j <plik>     - zapisuje wyniki jako JSON (- na wyjscie)\n"
+           " s            - sprawdza SSE2/AVX2 wzgledem wersji skalarnej\n"
+           " z <wartosc>  - ustawia ziarno pierwszej planszy\n\n", BENCH_REPS, BENCH_WARMUP);
+
+    exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+
+    /* Benchmark settings */
+    size_t reps = BENCH_REPS;
+    size_t warmup = BENCH_WARMUP;
+    uint64_t seed = BENCH_SEED;
+    const char *sizes = "LNTDO";
+    const char *only = "";
+    const char *json = NULL;
+    bool check = false;
+
+    while((opt = getopt(argc, argv, "hn:w:p:c:j:sz:")) != EOF)
+    {
+        switch(opt)
+        {
+            case 'h':
+                help();
+                break;
+
+            case 'n':
+                reps = (size_t) strtoull(optarg, NULL, 0);
+                break;
+
+            case 'w':
+                warmup = (size_t) strtoull(optarg, NULL, 0);
+                break;
+
+            case 'p':
+                sizes = optarg;
+                break;
+
+            case 'c':
+                only = optarg;
+                break;
+
+            case 'j':
+                json = optarg;
+                break;
+
+            case 's':
+                check = true;
+                break;
+
+            case 'z':
+                seed = strtoull(optarg, NULL, 0);
+                break;
+
+            default:
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Checking only, no timings */
+    if(check)
+        exit(bench_check(stdout, seed));
+
+    const size_t ncases = sizeof(g_cases) / sizeof(g_cases[0]);
+    const size_t nsizes = sizeof(g_sizes) / sizeof(g_sizes[0]);
+
+    bench_result_t *results = (bench_result_t *) malloc(sizeof(bench_result_t) * ncases * nsizes);
+    size_t count = 0;
+
+    if(! results)
+    {
+        fprintf(stderr, "Brak pamieci.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* The table goes aside if JSON is printed */
+    FILE *out = (json && strcmp(json, "-") == 0) ? stderr : stdout;
+
+    fprintf(out, "%-24s %-20s %7s %12s %12s %12s\n", "przypadek", "rozmiar", "powt.", "mediana ns", "p99 ns", "max ns");
+
+    for(size_t s = 0; s < nsizes; ++s)
+    {
+        const bench_size_t *size = &g_sizes[s];
+
+        if(! strchr(sizes, size->name[0]))
+            continue;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%s %zux%zu/%zu", size->name, size->rows, size->cols, size->mines);
+
+        for(size_t c = 0; c < ncases; ++c)
+        {
+            if(strncmp(g_cases[c].name, only, strlen(only)) != 0)
+                continue;
+
+            if(bench_run(&g_cases[c], size, seed, warmup, reps, &results[count]) != EXIT_SUCCESS)
+            {
+                fprintf(out, "%-24s %-20s %7s\n", g_cases[c].name, label, "-");
+                continue;
+            }
+
+            const bench_result_t *r = &results[count++];
+
+            fprintf(out, "%-24s %-20s %7zu %12llu %12llu %12llu\n", r->name, label, r->reps,
+                    (unsigned long long) r->median, (unsigned long long) r->p99, (unsigned long long) r->max);
+        }
+    }
+
+    remove(BENCH_FILE_TEXT);
+    remove(BENCH_FILE_BIN);
+
+    if(json)
+    {
+        FILE *file = (strcmp(json, "-") == 0) ? stdout : fopen(json, "w");
+
+        if(! file)
+        {
+            fprintf(stderr, "-j: Nie mozna zapisac pliku.\n");
+            free(results);
+            exit(EXIT_FAILURE);
+        }
+
+        bench_json(file, results, count, seed);
+
+        if(file != stdout)
+            fclose(file);
+    }
+
+    free(results);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+/*
+ *  bench.h
+ *
+ *  Micro-benchmarks of the grid: making,
+ *  completing, revealing, loading and
+ *  deleting boards of the game's sizes and
+ *  of big custom ones. Built as its own
+ *  program (make bench), with the grid code
+ *  only.
+ *
+ *  Every repetition gets a board of its own
+ *  (seed + repetition), made outside of the
+ *  timed part. Results are given as the
+ *  median and p99 of the repetitions, as a
+ *  table or as JSON.
+ *
+ *  With -s, the vectorized complete_grid is
+ *  checked against the scalar one instead.
+ *
+ */
+
+#ifndef _SAPER_BENCH_H_FILE_
+#define _SAPER_BENCH_H_FILE_
+
+/* Defaults */
+#define BENCH_WARMUP                5
+#define BENCH_REPS                  1000
+#define BENCH_SEED                  1
+
+/* A case stops after BENCH_BUDGET_S seconds,
+ * with at least BENCH_REPS_MIN repetitions */
+#define BENCH_BUDGET_S              0.5
+#define BENCH_REPS_MIN              11
+
+/* Board files of the grid_load cases */
+#define BENCH_FILE_TEXT             "saper-bench.txt.tmp"
+#define BENCH_FILE_BIN              "saper-bench.bin.tmp"
+
+/* Returned by a case not fit for a board */
+#define BENCH_SKIP                  UINT64_MAX
+
+
+#include "grid.h"
+#include "tile.h"
+
+#include <assert.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/* A board size. */
+typedef struct _sap_bench_size_t
+{
+    const char *name;
+    size_t rows;
+    size_t cols;
+    size_t mines;
+
+} bench_size_t;
+
+/* A case: makes its board, times one call,
+ * cleans up. Gives the time in ns, BENCH_SKIP
+ * if not fit for the board or out of memory. */
+typedef uint64_t (*bench_call_t)(const bench_size_t *size, uint64_t seed);
+
+/* A case, by name. */
+typedef struct _sap_bench_case_t
+{
+    const char *name;
+    bench_call_t call;
+
+} bench_case_t;
+
+/* Timings of a case on one size. */
+typedef struct _sap_bench_result_t
+{
+    const char *name;                       /* Case's name              */
+    const bench_size_t *size;               /* Board size               */
+    size_t reps;                            /* Timed repetitions        */
+    size_t skipped;                         /* Boards not fit           */
+    uint64_t min;                           /* Times (ns)               */
+    uint64_t median;
+    uint64_t p99;
+    uint64_t max;
+    double mean;
+
+} bench_result_t;
+
+
+/* Runs a case on one size.
+ *
+ *  test    - the case
+ *  size    - the board size
+ *  seed    - seed of the 1st board
+ *  warmup  - untimed repetitions
+ *  reps    - most timed repetitions
+ *  result  - the timings
+ *
+ * Returns 0 if succeeded, 1 if out of memory
+ * or no board was fit for the case.
+ */
+int         bench_run(const bench_case_t *test, const bench_size_t *size, uint64_t seed,
+                      size_t warmup, size_t reps, bench_result_t *result);
+
+/* Checks the SSE2/AVX2 box sums of
+ * complete_grid against the scalar one, on
+ * 1xN and Nx1 boards and on widths that
+ * leave a rest after 16 or 32 tiles, from
+ * no mines to all tiles but one.
+ *
+ *  out     - where the mismatches go
+ *  seed    - seed of the 1st board
+ *
+ * Returns 0 if all the boards match, 1 if
+ * one does not or out of memory.
+ */
+int         bench_check(FILE *out, uint64_t seed);
+
+/* Writes the timings as JSON.
+ *
+ *  file    - the output
+ *  results - the timings
+ *  count   - no. of the timings
+ *  seed    - seed of the run
+ */
+void        bench_json(FILE *file, const bench_result_t *results, size_t count, uint64_t seed);
+
+
+#endif /* _SAPER_BENCH_H_FILE_ */
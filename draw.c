@@ -7,265 +7,845 @@
 
 #include "draw.h"
 
-/* Initializes the drawing module.
- * Must be called once, at the beginning.
- */
-void draw_init(int settings)
+/* The grid's frame, kept between
+ * draws so it is allocated once. */
+static frame_t *g_frame = NULL;
+
+/* Position in the grid's log of changes
+ (grid->log_base + entries drawn), and
+ whether the whole grid must be drawn. */
+static size_t g_log_pos = 0;
+static bool g_redraw = true;
+
+/* Part of the grid on the screen (view):
+ its first tile and size in tiles, and
+ whether the old one must be cleared
+ (after a resize). */
+static size_t g_view_x = 0;
+static size_t g_view_y = 0;
+static size_t g_view_cols = 0;
+static size_t g_view_rows = 0;
+static bool g_clear = false;
+
+/* The overview is shown instead of the view */
+static bool g_overview = false;
+
+/* Arrows at an empty input move the view
+ (raw input only) */
+static bool g_keys = false;
+
+
+/* Color of a tile. */
+static color_t _draw_color(tile_t tile)
 {
-    cls();
-    cur_home();
+    if(g_settings & DRAW_MONO)
+        return COLOR_DEFAULT;
 
-    /* Copying the settings. */
-    g_settings = settings;
+    /* Unrevealed / flagged */
+    if(tile_up(tile) == FLAG)
+        return MAGENTA;
+
+    if(tile_up(tile) != REVEALED)
+        return COLOR_DEFAULT;
+
+    /* Revealed */
+    switch (tile_lo(tile))
+    {
+    case D1:
+    case D7:
+        return CYAN;
+
+    case D2:
+    case D4:
+    case D6:
+        return GREEN;
+
+    case D3:
+    case D5:
+    case D8:
+        return RED;
+
+    case MINE:
+        return YELLOW;
+
+    default:
+        return COLOR_DEFAULT;
+    }
+}
 
+/* Characters per tile. */
+static size_t _draw_width(void)
+{
+    return (g_settings & DRAW_COMPACT) ? DRAW_TILE_WIDTH_COMPACT : DRAW_TILE_WIDTH;
 }
 
-/* Sets global grid.
+/* Lines per row of tiles. */
+static size_t _draw_height(void)
+{
+    return (g_settings & DRAW_COMPACT) ? 1 : 2;
+}
+
+/* No. of digits of a number. */
+static size_t _draw_digits(size_t n)
+{
+    size_t digits = 1;
+
+    for(; n >= 10; n /= 10)
+        ++digits;
+
+    return digits;
+}
+
+/* Lines of column indexes. */
+static size_t _draw_index_lines(void)
+{
+    return (g_settings & DRAW_COL_INDEXING) ? _draw_digits(g_grid->cols) : 0;
+}
+
+/* Screen column of a tile's character. */
+static size_t _draw_col(size_t x)
+{
+    return g_grid_x + (x - g_view_x) * _draw_width() + 2;
+}
+
+/* Screen line of a tile's character. */
+static size_t _draw_line(size_t y)
+{
+    return g_grid_y + _draw_index_lines() + 1 + (y - g_view_y) * _draw_height();
+}
+
+/* Keeps the view inside the grid. */
+static void _draw_clamp(void)
+{
+    if(g_view_x + g_view_cols > g_grid->cols)
+        g_view_x = g_grid->cols - g_view_cols;
+
+    if(g_view_y + g_view_rows > g_grid->rows)
+        g_view_y = g_grid->rows - g_view_rows;
+}
+
+/* Sizes the view to the terminal, the
+ * whole grid if its size is not known. */
+static void _draw_fit(void)
+{
+    size_t term_cols, term_rows;
+
+    g_view_cols = g_grid->cols;
+    g_view_rows = g_grid->rows;
+
+    if(term_size(&term_cols, &term_rows))
+    {
+        char name[DRAW_NAME_LIMIT];
+        draw_row_name(g_grid->rows - 1, name);
+
+        /* Right of the grid: a space and the row's name */
+        const size_t label = (g_settings & DRAW_ROW_INDEXING) ? strlen(name) + 1 : 0;
+
+        /* Borders: '|' ... '|' or '|' ... ' |' */
+        const size_t border = (g_settings & DRAW_COMPACT) ? 3 : 1;
+
+        /* Above: indexes and the border, below: the border */
+        const size_t lines = g_grid_y + _draw_index_lines() + 2;
+
+        const size_t fit_cols = (term_cols > g_grid_x + border + label) ?
+                                (term_cols - g_grid_x - border - label) / _draw_width() : 0;
+
+        const size_t fit_rows = (term_rows > lines) ?
+                                (term_rows - lines + _draw_height() - 1) / _draw_height() : 0;
+
+        /* At least a tile, even if it does not fit */
+        if(fit_cols < g_view_cols)
+            g_view_cols = fit_cols ? fit_cols : 1;
+
+        if(fit_rows < g_view_rows)
+            g_view_rows = fit_rows ? fit_rows : 1;
+    }
+
+    _draw_clamp();
+}
+
+/* Draws a whole line of borders.
  *
- *  grid    - the grid to be set
+ *  f       - the frame
+ *  left, cross, right, line - the characters
  */
-void draw_attach(const grid_t *grid, size_t x, size_t y)
+static void _draw_border(frame_t *f, char left, char cross, char right, char line)
 {
-    /* Pointer checking */
-    assert(grid);
-    g_grid = grid;
-
-    cur_home();
+    const size_t width_char = g_view_cols * _draw_width() + ((g_settings & DRAW_COMPACT) ? 2 : 0);
 
-    g_grid_x = x;
-    g_grid_y = y;
+    frame_putc(f, left);
 
-    /* "Reserving" terminal area. */
-    for(int i = 0; i < (g_grid_y * 4); ++i)
-        printf("\n");
+    for(size_t i = 1; i < width_char; ++i)
+        frame_putc(f, (i % DRAW_TILE_WIDTH == 0 && ! (g_settings & DRAW_COMPACT)) ? cross : line);
 
-    cur_home();
+    frame_putc(f, right);
 }
 
-/* Draws the grid.
+/* Draws the whole view: indexes, borders
+ * and the visible tiles.
+ *
+ *  f       - the frame
  */
-void draw_grid(void)
+static void _draw_full(frame_t *f)
 {
-    const size_t tile_width = 4;
+    const size_t width = _draw_width();
+    const bool compact = (g_settings & DRAW_COMPACT);
+    size_t line = g_grid_y;
 
-    /* Pointer checking */
-    assert(g_grid);
+    /* The last row has the longest name */
+    char name[DRAW_NAME_LIMIT];
+    draw_row_name(g_grid->rows - 1, name);
 
-    /* Tile width checking */
-    assert(tile_width % 2 == 0);
+    const size_t name_len = strlen(name);
 
-    /* Moving the cursor. */
-    cur_to(g_grid_x, g_grid_y);
+    /* The old view may have been bigger */
+    /* (a moved one is drawn all over)  */
+    if(g_clear)
+    {
+        frame_to(f, 0, g_grid_y);
+        frame_erase(f);
+        g_clear = false;
+    }
 
     /* First stage - column indexes */
-    if(g_settings & DRAW_COL_INDEXING)
+    /* (above the tiles' centers,   */
+    /*  a line per digit)           */
+    const size_t digits = _draw_index_lines();
+
+    for(size_t d = digits; d > 0; --d)
     {
-        printf("\t");
-        cur_move(RIGHT, 1);
+        size_t power = 1;
+        for(size_t i = 1; i < d; ++i)
+            power *= 10;
 
-        /* Less columns than 10: */
-        if(g_grid->cols < 10)
+        frame_to(f, _draw_col(g_view_x), line++);
+
+        for(size_t x = g_view_x + 1; x <= g_view_x + g_view_cols; ++x)
         {
-            for(size_t x = 0; x < g_grid->cols; ++x)
-            {
-                printf("%zu", (x + 1));
-                for(size_t i = 0; i < tile_width - 1; ++i)
-                    printf(" ");
-            }
+            frame_putc(f, x >= power ? (char) ('0' + x / power % 10) : ' ');
 
-            printf("\n\t");
-            cur_move(LEFT, 1);
+            for(size_t i = 0; i < width - 1; ++i)
+                frame_putc(f, ' ');
         }
+    }
 
-        /* More columns: */
-        else
+    /* Second stage - upper border */
+    frame_to(f, g_grid_x, line++);
+    _draw_border(f, (char) CHAR_SG_CORNER_LU, (char) CHAR_SG_CROSS_U, (char) CHAR_SG_CORNER_RU, (char) CHAR_SG_HORIZONT);
+
+    /* Third stage - each row with indexing* */
+    for(size_t y = g_view_y; y < g_view_y + g_view_rows; ++y)
+    {
+        /* TILE ROW */
+
+        const tile_t *row = grid_row(g_grid, y);
+
+        frame_to(f, g_grid_x, line++);
+
+        if(compact)
+            frame_putc(f, (char) CHAR_SG_VERTICAL);
+
+        for(size_t x = g_view_x; x < g_view_x + g_view_cols; ++x)
         {
-            /* First row: */
-            for(size_t x = 1; x <= g_grid->cols; ++x)
+            /* Borders in the default color, */
+            /* spaces in any                 */
+            if(! compact)
             {
-                printf("%c", x >= 10 ? (char)(x / 10) + '0' : ' ');
-                for(size_t i = 0; i < tile_width - 1; ++i)
-                    printf(" ");
+                frame_color(f, COLOR_DEFAULT);
+                frame_putc(f, (char) CHAR_SG_VERTICAL);
             }
 
-            printf("\n\t");
+            frame_putc(f, ' ');
 
-            /* Left margin */
-            for(size_t i = 0; i < tile_width / 2 - 1; ++i)
-                printf(" ");
+            /* Drawing the tile */
+            frame_color(f, _draw_color(row[x]));
+            frame_putc(f, tile_char(row[x]));
 
-            /* Second row: */
-            for(size_t x = 1; x <= g_grid->cols; ++x)
-            {
-                printf("%zu", x % 10);
+            if(! compact)
+                frame_putc(f, ' ');
+        }
 
-                for(size_t i = 0; i < tile_width - 1; ++i)
-                    printf(" ");
-            }
+        frame_color(f, COLOR_DEFAULT);
+
+        if(compact)
+            frame_putc(f, ' ');
+
+        frame_putc(f, (char) CHAR_SG_VERTICAL);
 
-            printf("\n\t");
-            cur_move(LEFT, 1);
+        /* Row indexing (if specified) */
+        /* (padded, as names of the old */
+        /*  view may have been longer)  */
+        if(g_settings & DRAW_ROW_INDEXING)
+        {
+            char name[DRAW_NAME_LIMIT];
+            draw_row_name(y, name);
+
+            frame_move(f, RIGHT, 1);
+            frame_puts(f, name);
+
+            for(size_t i = strlen(name); i < name_len; ++i)
+                frame_putc(f, ' ');
         }
+
+        /* BORDER ROW */
+
+        if(y == g_view_y + g_view_rows - 1 || compact)
+            continue;
+
+        frame_to(f, g_grid_x, line++);
+        _draw_border(f, (char) CHAR_SG_CROSS_L, (char) CHAR_SG_CROSS, (char) CHAR_SG_CROSS_R, (char) CHAR_SG_HORIZONT);
     }
-    else
+
+    /* Fourth stage - bottom border */
+    frame_to(f, g_grid_x, line);
+    _draw_border(f, (char) CHAR_SG_CORNER_LD, (char) CHAR_SG_CROSS_D, (char) CHAR_SG_CORNER_RD, (char) CHAR_SG_HORIZONT);
+}
+
+/* Draws the visible tiles changed since the
+ * last draw, each where it is on the screen.
+ *
+ *  f       - the frame
+ *  from    - first entry of the grid's log
+ */
+static void _draw_changed(frame_t *f, size_t from)
+{
+    for(size_t i = from; i < g_grid->log_len; ++i)
+    {
+        const size_t pos = g_grid->log[i];
+        const size_t x = pos % g_grid->cols;
+        const size_t y = pos / g_grid->cols;
+
+        /* Out of the view */
+        if(x < g_view_x || x >= g_view_x + g_view_cols || y < g_view_y || y >= g_view_y + g_view_rows)
+            continue;
+
+        frame_to(f, _draw_col(x), _draw_line(y));
+        frame_color(f, _draw_color(g_grid->tiles[pos]));
+        frame_putc(f, tile_char(g_grid->tiles[pos]));
+    }
+}
+
+/* Adds a character of the overview.
+ *
+ *  f       - the frame
+ *  dots    - its dots (bit 0 - dot 1, ...)
+ */
+static void _draw_dots(frame_t *f, uint8_t dots)
+{
+#ifdef DRAW_BRAILLE
+    /* U+2800 + dots, in UTF-8 */
+    const char code[3] = { (char) 0xE2, (char) (0xA0 | (dots >> 6)), (char) (0x80 | (dots & 0x3F)) };
+
+    frame_add(f, code, 3);
+#else
+    /* Shades, by the number of dots */
+    const int n = __builtin_popcount(dots);
+
+    frame_putc(f, (char) (n == 0 ? ' ' : n <= 2 ? 176 : n <= 5 ? 177 : n <= 7 ? 178 : 219));
+#endif
+}
+
+/* Draws the overview: a character per 2x4
+ * blocks of tiles, a dot if most of a block
+ * is unrevealed. Made in one pass over the
+ * grid, a line of characters at a time.
+ *
+ *  f       - the frame
+ */
+static void _draw_overview(frame_t *f)
+{
+    const size_t cols = g_grid->cols;
+    const size_t rows = g_grid->rows;
+
+    char name[DRAW_NAME_LIMIT];
+    draw_row_name(rows - 1, name);
+
+    const size_t name_len = strlen(name);
+
+    /* Room for it: borders and row names */
+    /* aside, marks and borders above and */
+    /* below                              */
+    size_t width = DRAW_OVERVIEW_COLS;
+    size_t height = DRAW_OVERVIEW_ROWS;
+    size_t term_cols, term_rows;
+
+    if(term_size(&term_cols, &term_rows))
     {
-        /* No indexing, just a margin */
-        printf("\t");
-        cur_move(LEFT, 1);
+        width = (term_cols > g_grid_x + 3 + name_len) ? term_cols - g_grid_x - 3 - name_len : 1;
+        height = (term_rows > g_grid_y + 3) ? term_rows - g_grid_y - 3 : 1;
     }
 
+    /* Tiles per dot, the same both ways */
+    size_t scale = (cols + 2 * width - 1) / (2 * width);
 
-    /* Second stage - upper border */
+    if((rows + 4 * height - 1) / (4 * height) > scale)
+        scale = (rows + 4 * height - 1) / (4 * height);
+
+    if(scale == 0)
+        scale = 1;
+
+    const size_t cells_x = (cols + 2 * scale - 1) / (2 * scale);
+    const size_t cells_y = (rows + 4 * scale - 1) / (4 * scale);
 
-    const size_t width_char = (g_grid->cols) * tile_width;
+    /* Per dot of a line: tiles, unrevealed ones */
+    /* per character: flags (1), mines (2)      */
+    uint32_t *count = (uint32_t *) malloc(sizeof(uint32_t) * cells_x * 16);
+    uint8_t *marks = (uint8_t *) malloc(cells_x);
 
-    for(size_t i = 0; i <= width_char; ++i)
+    if(! count || ! marks)
     {
-        if(i == 0)
-            printf("%c", CHAR_SG_CORNER_LU);
+        free(count);
+        free(marks);
+        return;
+    }
 
-        else if(i == width_char)
-            printf("%c", CHAR_SG_CORNER_RU);
+    /* The view may have been bigger */
+    if(g_clear)
+    {
+        frame_to(f, 0, g_grid_y);
+        frame_erase(f);
+        g_clear = false;
+    }
+
+    /* Column marks, every 10 characters */
+    frame_to(f, g_grid_x + 1, g_grid_y);
 
-        else if(i > 1 && i < width_char && i % tile_width == 0)
-            printf("%c", CHAR_SG_CROSS_U);
+    for(size_t c = 0; c < cells_x; )
+    {
+        char mark[24];
+        const size_t len = (size_t) snprintf(mark, sizeof(mark), "%zu", c * 2 * scale + 1);
 
+        if(c % 10 == 0 && c + len <= cells_x)
+        {
+            frame_puts(f, mark);
+            c += len;
+        }
         else
-           printf("%c", CHAR_SG_HORIZONT);
+        {
+            frame_putc(f, ' ');
+            ++c;
+        }
     }
 
-    printf("\n\t");
-    cur_move(LEFT, 1);
+    /* Upper border, with the scale */
+    char label[32];
+    const size_t label_len = (size_t) snprintf(label, sizeof(label), " 1:%zu ", scale);
 
-    /* Third stage - each row with indexing* */
-    for(size_t y = 0; y < g_grid->rows; ++y)
+    frame_to(f, g_grid_x, g_grid_y + 1);
+    frame_putc(f, (char) CHAR_SG_CORNER_LU);
+
+    if(label_len <= cells_x)
+        frame_puts(f, label);
+
+    for(size_t c = (label_len <= cells_x) ? label_len : 0; c < cells_x; ++c)
+        frame_putc(f, (char) CHAR_SG_HORIZONT);
+
+    frame_putc(f, (char) CHAR_SG_CORNER_RU);
+
+    /* Lines of characters */
+    for(size_t cy = 0; cy < cells_y; ++cy)
     {
-        /* TILE ROW */
+        const size_t y_first = cy * 4 * scale;
+        const size_t y_end = (y_first + 4 * scale < rows) ? y_first + 4 * scale : rows;
 
-        size_t gx = 0;
+        memset(count, 0, sizeof(uint32_t) * cells_x * 16);
+        memset(marks, 0, cells_x);
 
-        for(size_t x = 0; x <= width_char; ++x)
+        for(size_t y = y_first; y < y_end; ++y)
         {
-            if(x == 0 || x == width_char || x % tile_width == 0)
-                printf("%c", CHAR_SG_VERTICAL);
+            const tile_t *row = grid_row(g_grid, y);
+            const size_t dy = (y - y_first) / scale;
 
-            /* Drawing the tile */
-            else if(x % tile_width == (tile_width / 2))
+            /* Blocks of the row, tile by tile */
+            for(size_t sx = 0, x = 0; x < cols; ++sx)
             {
-                char c;
+                /* Braille order: dots 1-3 and 4-6 in */
+                /* columns, then 7 and 8 at the bottom */
+                const size_t bit = (dy < 3) ? (sx % 2) * 3 + dy : 6 + sx % 2;
+                uint32_t *dot = &count[((sx / 2) * 8 + bit) * 2];
+                uint8_t *mark = &marks[sx / 2];
 
-                /* Revealed */
-                if(grid_at(g_grid, gx, y)->up == REVEALED)
+                for(size_t k = 0; k < scale && x < cols; ++k, ++x)
                 {
-                    c = (char) grid_at(g_grid, gx, y)->lo;
-                    ++gx;
-                }
+                    const up_layer_t up = tile_up(row[x]);
 
-                /* Unrevealed / flagged */
-                else
-                {
-                    c = (char) grid_at(g_grid, gx, y)->up;
-                    ++gx;
+                    ++dot[0];
+                    dot[1] += (up != REVEALED);
+
+                    if(up == FLAG)
+                        *mark |= 1;
+                    else if(up == REVEALED && tile_lo(row[x]) == MINE)
+                        *mark |= 2;
                 }
+            }
+        }
 
-                /* Color */
-                color_t col = COLOR_DEFAULT;
+        frame_to(f, g_grid_x, g_grid_y + 2 + cy);
+        frame_color(f, COLOR_DEFAULT);
+        frame_putc(f, (char) CHAR_SG_VERTICAL);
 
-                if(! (g_settings & DRAW_MONO))
-                {
-                    switch ((lo_layer_t) c)
-                    {
-                    case D1:
-                    case D7:
-                        col = CYAN;
-                        break;
-
-                    case D2:
-                    case D4:
-                    case D6:
-                        col = GREEN;
-                        break;
-
-                    case D3:
-                    case D5:
-                    case D8:
-                        col = RED;
-                        break;
-
-                    case FLAG:
-                        col = MAGENTA;
-                        break;
-
-                    case MINE:
-                        col = YELLOW;
-                        break;
-
-                    default:
-                        break;
-                    }
-                }
+        for(size_t cx = 0; cx < cells_x; ++cx)
+        {
+            uint8_t dots = 0;
+
+            for(size_t bit = 0; bit < 8; ++bit)
+            {
+                const uint32_t *dot = &count[(cx * 8 + bit) * 2];
 
-                col_set(col);
-                printf("%c", c);
-                col_set(COLOR_DEFAULT);
+                if(dot[0] > 0 && 2 * dot[1] > dot[0])
+                    dots |= (uint8_t) (1 << bit);
             }
 
-            else
-                printf(" ");
-        }
+            /* Mines, flags, then the view */
+            const size_t x_first = cx * 2 * scale;
+            const bool in_view = x_first < g_view_x + g_view_cols && x_first + 2 * scale > g_view_x &&
+                                 y_first < g_view_y + g_view_rows && y_end > g_view_y;
 
-        /* Row indexing (if specified) */
-        /* Does not work if many letters required */
-        if(g_settings & DRAW_ROW_INDEXING && g_grid->rows <= ('z' - 'a'))
-        {
-            cur_move(RIGHT, 1);
+            color_t col = (marks[cx] & 2) ? YELLOW : (marks[cx] & 1) ? MAGENTA : in_view ? CYAN : COLOR_DEFAULT;
 
-            printf("%c", (char)('a' + y));
+            frame_color(f, (g_settings & DRAW_MONO) ? COLOR_DEFAULT : col);
+            _draw_dots(f, dots);
         }
 
-        printf("\n\t");
-        cur_move(LEFT, 1);
+        frame_color(f, COLOR_DEFAULT);
+        frame_putc(f, (char) CHAR_SG_VERTICAL);
 
-        /* BORDER ROW */
+        /* Name of the first row */
+        draw_row_name(y_first, name);
+
+        frame_move(f, RIGHT, 1);
+        frame_puts(f, name);
 
-        if(y == g_grid->rows - 1)
+        for(size_t i = strlen(name); i < name_len; ++i)
+            frame_putc(f, ' ');
+    }
+
+    /* Bottom border */
+    frame_to(f, g_grid_x, g_grid_y + 2 + cells_y);
+    frame_putc(f, (char) CHAR_SG_CORNER_LD);
+
+    for(size_t c = 0; c < cells_x; ++c)
+        frame_putc(f, (char) CHAR_SG_HORIZONT);
+
+    frame_putc(f, (char) CHAR_SG_CORNER_RD);
+
+    free(count);
+    free(marks);
+}
+
+/* Reads a line from the raw input, echoing
+ * it. The arrows, at an empty line, give the
+ * view's commands (wg, wd, wp, wl) at once.
+ * The grid is drawn anew after a resize.
+ *
+ *  input   - the line (INPUT_CHAR_LIMIT chars)
+ *  comm    - comment, text next to the input
+ */
+static void _draw_read(char *input, const char *comm)
+{
+    size_t len = 0;
+    input[0] = '\0';
+
+    fflush(stdout);
+
+    for(;;)
+    {
+        const int key = term_key(-1);
+
+        /* Resized, the line back after the grid */
+        if(key == TERM_KEY_NONE)
+        {
+            if(g_keys && g_grid && term_resized())
+            {
+                g_redraw = g_clear = true;
+                _draw_fit();
+                draw_grid();
+
+                cur_home();
+                clr_line();
+                printf("%s %s", comm, input);
+                fflush(stdout);
+            }
+
+            continue;
+        }
+
+        if(key == TERM_KEY_EOF || key == '\r' || key == '\n')
             break;
 
-        for(size_t x = 0; x <= width_char; ++x)
+        /* Moving the view */
+        if(key >= TERM_KEY_ARROW)
         {
-            if(x == 0)
-                printf("%c", CHAR_SG_CROSS_L);
+            if(g_keys && len == 0)
+            {
+                const char dirs[] = { 'g', 'd', 'p', 'l' };
 
-            else if(x == width_char)
-                printf("%c", CHAR_SG_CROSS_R);
+                input[0] = 'w';
+                input[1] = dirs[key - TERM_KEY_ARROW];
+                input[2] = '\0';
+                break;
+            }
 
-            else if(x % tile_width == 0)
-                printf("%c", CHAR_SG_CROSS);
+            continue;
+        }
 
-            else
-                printf("%c", CHAR_SG_HORIZONT);
+        /* Backspace */
+        if(key == 0x7F || key == '\b')
+        {
+            if(len > 0)
+            {
+                input[--len] = '\0';
+                printf("\b \b");
+                fflush(stdout);
+            }
+
+            continue;
         }
 
-        printf("\n\t");
-        cur_move(LEFT, 1);
+        if(! isprint(key) || len + 1 >= INPUT_CHAR_LIMIT)
+            continue;
+
+        input[len++] = (char) key;
+        input[len] = '\0';
+
+        putchar(key);
+        fflush(stdout);
     }
+}
 
-    /* Fourth stage - bottom border */
+/* Initializes the drawing module.
+ * Must be called once, at the beginning.
+ */
+void draw_init(int settings)
+{
+    /* Own screen and raw input, if a terminal */
+    term_open();
+
+    cls();
+
+    /* Copying the settings. */
+    g_settings = settings;
+
+    /* The view follows the terminal's size */
+    term_watch();
+}
+
+/* Sets global grid.
+ *
+ *  grid    - the grid to be set
+ */
+void draw_attach(const grid_t *grid, size_t x, size_t y)
+{
+    /* Pointer checking */
+    assert(grid);
+    g_grid = grid;
+
+    cur_home();
+
+    g_grid_x = x;
+    g_grid_y = y;
+
+    /* Whole view at the first draw */
+    g_view_x = g_view_y = 0;
+    _draw_fit();
+    g_redraw = true;
+
+    /* "Reserving" terminal area. */
+    for(int i = 0; i < (g_grid_y * 4); ++i)
+        printf("\n");
+
+    cur_home();
+}
+
+/* Draws the visible part of the grid, as
+ * one frame. Only the tiles changed since
+ * the last draw are drawn, unless the whole
+ * view is needed (also after a resize).
+ */
+void draw_grid(void)
+{
+    /* Pointer checking */
+    assert(g_grid);
+
+    /* Tile width checking */
+    assert(DRAW_TILE_WIDTH % 2 == 0);
+
+    /* First draw */
+    if(! g_frame && ! (g_frame = new_frame()))
+        return;
+
+    /* New size of the view */
+    if(term_resized())
+    {
+        _draw_fit();
+        g_redraw = g_clear = true;
+    }
+
+    /* Changes not read yet */
+    const bool gap = (g_log_pos < g_grid->log_base);
+    const size_t from = gap ? 0 : g_log_pos - g_grid->log_base;
+    const size_t changed = g_grid->log_len - from;
 
-    for(size_t i = 0; i <= width_char; ++i)
+    /* The overview, whole if anything changed */
+    if(g_overview)
     {
-        if(i == 0)
-            printf("%c", CHAR_SG_CORNER_LD);
+        if(g_redraw || gap || changed > 0)
+            _draw_overview(g_frame);
+    }
 
-        else if(i == width_char)
-            printf("%c", CHAR_SG_CORNER_RD);
+    /* Everything anew: first draw, a gap in */
+    /* the log, or most of the view changed  */
+    else if(g_redraw || gap || changed * DRAW_FULL_SHARE > g_view_rows * g_view_cols)
+        _draw_full(g_frame);
+    else
+        _draw_changed(g_frame, from);
 
-        else if(i > 1 && i < width_char && i % tile_width == 0)
-            printf("%c", CHAR_SG_CROSS_D);
+    g_redraw = false;
+    g_log_pos = g_grid->log_base + g_grid->log_len;
 
-        else
-           printf("%c", CHAR_SG_HORIZONT);
+    frame_color(g_frame, COLOR_DEFAULT);
+    frame_flush(g_frame);
+}
+
+/* Makes the next draw_grid draw the whole
+ * grid (after the screen was cleared).
+ */
+void draw_invalidate(void)
+{
+    g_redraw = true;
+}
+
+/* Moves the view by half of its size.
+ *
+ *  dir     - the direction
+ */
+void draw_pan(dir_t dir)
+{
+    /* Pointer checking */
+    assert(g_grid);
+
+    /* Back to the view */
+    if(g_overview)
+        g_overview = false, g_clear = true;
+
+    const size_t step_x = g_view_cols > 1 ? g_view_cols / 2 : 1;
+    const size_t step_y = g_view_rows > 1 ? g_view_rows / 2 : 1;
+
+    switch(dir)
+    {
+        case UP:
+            g_view_y = g_view_y > step_y ? g_view_y - step_y : 0;
+            break;
+        case DOWN:
+            g_view_y += step_y;
+            break;
+        case LEFT:
+            g_view_x = g_view_x > step_x ? g_view_x - step_x : 0;
+            break;
+        case RIGHT:
+            g_view_x += step_x;
+            break;
+        default:
+            return;
     }
+
+    _draw_clamp();
+    g_redraw = true;
+}
+
+/* Moves the view, so a tile is in its middle.
+ *
+ *  x, y    - the tile's position
+ */
+void draw_center(size_t x, size_t y)
+{
+    /* Pointer checking */
+    assert(g_grid);
+
+    /* Back to the view */
+    if(g_overview)
+        g_overview = false, g_clear = true;
+
+    g_view_x = x > g_view_cols / 2 ? x - g_view_cols / 2 : 0;
+    g_view_y = y > g_view_rows / 2 ? y - g_view_rows / 2 : 0;
+
+    _draw_clamp();
+    g_redraw = true;
+}
+
+/* Moves the view as little as needed to
+ * show a tile.
+ *
+ *  x, y    - the tile's position
+ */
+void draw_show(size_t x, size_t y)
+{
+    /* Pointer checking */
+    assert(g_grid);
+
+    const size_t old_x = g_view_x;
+    const size_t old_y = g_view_y;
+
+    if(x < g_view_x)
+        g_view_x = x;
+    else if(x >= g_view_x + g_view_cols)
+        g_view_x = x - g_view_cols + 1;
+
+    if(y < g_view_y)
+        g_view_y = y;
+    else if(y >= g_view_y + g_view_rows)
+        g_view_y = y - g_view_rows + 1;
+
+    if(g_view_x != old_x || g_view_y != old_y)
+        g_redraw = true;
+}
+
+/* Switches between the view and the overview:
+ * the whole grid, a dot per block of tiles,
+ * with the view, flags and mines in colors.
+ * Moving the view goes back to it.
+ *
+ * Returns true if the overview is shown.
+ */
+bool draw_overview(void)
+{
+    g_overview = ! g_overview;
+    g_redraw = g_clear = true;
+
+    return g_overview;
+}
+
+/* Lets the arrows move the view at once,
+ * at an empty input (with raw input).
+ *
+ *  on      - if they do
+ */
+void draw_keys(bool on)
+{
+    g_keys = on;
+}
+
+/* Gives the name of a row: a... z, aa, ab...
+ *
+ *  y       - the row's index
+ *  name    - the name (DRAW_NAME_LIMIT chars)
+ */
+void draw_row_name(size_t y, char *name)
+{
+    /* Pointer checking */
+    assert(name);
+
+    char rev[DRAW_NAME_LIMIT];
+    size_t len = 0;
+
+    /* Bijective base 26, as spreadsheet columns */
+    for(size_t n = y + 1; n > 0 && len < DRAW_NAME_LIMIT - 1; n = (n - 1) / 26)
+        rev[len++] = (char) ('a' + (n - 1) % 26);
+
+    for(size_t i = 0; i < len; ++i)
+        name[i] = rev[len - 1 - i];
+
+    name[len] = '\0';
 }
 
 /* Draws the input module.
@@ -317,8 +897,11 @@ char *draw_finput(FILE *stream, const char *comm, size_t x, size_t y)
     clr_line();
     printf("%s ", comm);
 
-    /* Input */
-    fgets(input, INPUT_CHAR_LIMIT, stream);
+    /* Input, key by key if raw */
+    if(stream == stdin && term_raw())
+        _draw_read(input, comm);
+    else
+        fgets(input, INPUT_CHAR_LIMIT, stream);
 
     cur_load();
 
@@ -11,13 +11,36 @@
 #define DRAW_MONO                 1          /* Black/white                  */
 #define DRAW_ROW_INDEXING         (1 << 1)   /* Row indexing (1, 2, 3... )   */
 #define DRAW_COL_INDEXING         (1 << 2)   /* Column indexing (a, b, c...) */
+#define DRAW_COMPACT              (1 << 3)   /* 2 characters per tile        */
 
 #define INPUT_CHAR_LIMIT          32
 
+#define DRAW_TILE_WIDTH           4          /* Characters per tile, even    */
+#define DRAW_TILE_WIDTH_COMPACT   2          /* The same, DRAW_COMPACT       */
+#define DRAW_NAME_LIMIT           8          /* Row names (a... z, aa, ab...)*/
+
+/* Overview's size if the terminal's one
+ * is not known (characters) */
+#define DRAW_OVERVIEW_COLS        72
+#define DRAW_OVERVIEW_ROWS        16
+
+/* Overview in braille (UTF-8), 2x4 dots
+ * per character, else in shades */
+#ifdef __linux__
+    #define DRAW_BRAILLE
+#endif
+
+/* Whole grid drawn again if more than
+ * 1/DRAW_FULL_SHARE of the tiles changed */
+#define DRAW_FULL_SHARE           2
+
 #include "grid.h"
 #include "terminal.h"
 
 #include <assert.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <getopt.h>
@@ -30,7 +53,8 @@
  */
 static const grid_t *g_grid = NULL;
 
-/* The grid's location. 
+/* The grid's location: column of its
+ left border, line of its first line.
  */
 static size_t g_grid_x = 1;
 static size_t g_grid_y = 1;
@@ -52,10 +76,60 @@ void        draw_init(int settings);
  */
 void        draw_attach(const grid_t *grid, size_t x, size_t y);
 
-/* Draws the grid. 
+/* Draws the visible part of the grid, as
+ * one frame. Only the tiles changed since
+ * the last draw are drawn, unless the whole
+ * view is needed (also after a resize).
  */
 void        draw_grid(void);
 
+/* Makes the next draw_grid draw the whole
+ * grid (after the screen was cleared).
+ */
+void        draw_invalidate(void);
+
+/* Moves the view by half of its size.
+ *
+ *  dir     - the direction
+ */
+void        draw_pan(dir_t dir);
+
+/* Moves the view, so a tile is in its middle.
+ *
+ *  x, y    - the tile's position
+ */
+void        draw_center(size_t x, size_t y);
+
+/* Moves the view as little as needed to
+ * show a tile.
+ *
+ *  x, y    - the tile's position
+ */
+void        draw_show(size_t x, size_t y);
+
+/* Switches between the view and the overview:
+ * the whole grid, a dot per block of tiles,
+ * with the view, flags and mines in colors.
+ * Moving the view goes back to it.
+ *
+ * Returns true if the overview is shown.
+ */
+bool        draw_overview(void);
+
+/* Lets the arrows move the view at once,
+ * at an empty input (with raw input).
+ *
+ *  on      - if they do
+ */
+void        draw_keys(bool on);
+
+/* Gives the name of a row: a... z, aa, ab...
+ *
+ *  y       - the row's index
+ *  name    - the name (DRAW_NAME_LIMIT chars)
+ */
+void        draw_row_name(size_t y, char *name);
+
 /* Draws the input module. 
  *
  *  comm        - comment, text next to the input
@@ -13,17 +13,29 @@ void _game_on_exit(void)
     col_set(COLOR_DEFAULT);
     cls();
     cur_home();
+
+    /* The shell's screen back */
+    term_close();
+}
+
+/* Current time in seconds. */
+static double _game_now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
 }
 
 
 /* Starts the game.
  *
- *  settings - the game options
+ *  settings - the game options (DRAW_* and GAME_* constants)
  *  filegrid - file to read the grid from (can be NULL)
  *  filemove - file to read movement from (can be NULL)
  *  seed     - seed value
  */
-void game_init(int settings, const char *filegrid, const char *filemove, unsigned int seed)
+void game_init(int settings, const char *filegrid, const char *filemove, uint64_t seed)
 {
     /* Initializing the modules */
     draw_init(settings);
@@ -40,10 +52,23 @@ void game_init(int settings, const char *filegrid, const char *filemove, unsigne
     }
 
     /* Loading grid from file, if provided */
-    if(filegrid && ! (g_rules.grid = grid_load(filegrid)))
+    size_t line = 0;
+
+    if(filegrid && ! (g_rules.grid = grid_load(filegrid, &line)))
+    {
+        /* Error, with the bad line if known */
+        char buffer[BUFFER_CHAR_LIMIT] = "Nie mozna zaladowac planszy z pliku, konczenie...";
+
+        if(line > 0)
+            sprintf(buffer, "Blad planszy w linii %zu, konczenie...", line);
+
+        draw_label(buffer, LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
+        exit(EXIT_FAILURE);
+    }
+    else if(filegrid && (g_rules.grid->rows > GRID_MAX_HEIGHT || g_rules.grid->cols > GRID_MAX_WIDTH))
     {
         /* Error */
-        draw_label("Nie mozna zaladowac planszy z pliku, konczenie...", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
+        draw_label("Plansza z pliku jest za duza, konczenie...", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
         exit(EXIT_FAILURE);
     }
     else if(filegrid)
@@ -53,12 +78,7 @@ void game_init(int settings, const char *filegrid, const char *filemove, unsigne
         g_rules.rows = g_rules.grid->rows;
         g_rules.score = 0;
         g_rules.seed = 0;
-        g_rules.mines = 0;
-
-        for(size_t y = 0; y < g_rules.rows; ++y)
-            for(size_t x = 0; x < g_rules.cols; ++x)
-                if(grid_at(g_rules.grid, x, y)->lo == MINE)
-                    ++g_rules.mines;
+        g_rules.mines = g_rules.grid->mines;
     }
 
     while(! filegrid)
@@ -154,7 +174,23 @@ void game_init(int settings, const char *filegrid, const char *filemove, unsigne
     }
 
     /* Creating the grid */
-    if(! filegrid && ! (g_rules.grid = new_grid(g_rules.rows, g_rules.cols, g_rules.mines, g_rules.seed)))
+    /* (mines placed after the 1st move if asked, not in the editor) */
+    if(! filegrid && (settings & GAME_SAFE_OPENING) && ! (settings & GAME_EDITOR))
+        g_rules.grid = new_grid_deferred(g_rules.rows, g_rules.cols, g_rules.mines, g_rules.seed);
+
+    else if(! filegrid)
+        g_rules.grid = new_grid(g_rules.rows, g_rules.cols, g_rules.mines, g_rules.seed);
+
+    if(! g_rules.grid)
+    {
+        /* Error */
+        draw_label("Blad krytyczny, konczenie...", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Hints, only while playing */
+    if(! (settings & GAME_EDITOR) && (! (g_rules.solver = new_solver(g_rules.grid)) ||
+                                      ! (g_rules.odds = new_odds(g_rules.grid, 0))))
     {
         /* Error */
         draw_label("Blad krytyczny, konczenie...", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
@@ -162,11 +198,18 @@ void game_init(int settings, const char *filegrid, const char *filemove, unsigne
     }
 
     g_rules.move = filemove ? g_rules.move : stdin;
+    g_rules.no_guess = (settings & GAME_NO_GUESS) && g_rules.grid->pending;
 
     draw_attach(g_rules.grid, LOCATION_GRID_X, LOCATION_GRID_Y);
 
+    /* Arrows move the view */
+    draw_keys(true);
+
     /* Entering the loop */
-    game_loop();
+    if(settings & GAME_EDITOR)
+        game_edit();
+    else
+        game_loop();
 }
 
 /* The game loop.
@@ -179,6 +222,8 @@ void game_loop(void)
     /* Drawing the grid */
     draw_grid();
 
+    g_rules.start = _game_now();
+
     /* THE LOOP */
     while(g_rules.state == RUNNING)
     {
@@ -187,12 +232,15 @@ void game_loop(void)
         /* User move */
         while(true)
         {
-            /* Writing score */
-            /* Only if predefined difficulty */
-            if(g_rules.diff != OWN)
+            /* After a resize or a moved view */
+            /* (nothing drawn otherwise)      */
+            draw_grid();
+
+            /* Writing tiles left, the score is */
+            /* counted at the end of the game   */
             {
                 char buffer[BUFFER_CHAR_LIMIT];
-                sprintf(buffer, "Wynik: %zu", g_rules.score);
+                sprintf(buffer, "Do odkrycia: %zu", grid->safe_left);
                 draw_label(buffer, LOCATION_SCORE_X, LOCATION_SCORE_Y, 0);
             }
 
@@ -223,8 +271,65 @@ void game_loop(void)
                 exit(EXIT_SUCCESS);
             }
 
+            /* Hint, a move that is certainly right */
+            if(move->reveal == 4)
+            {
+                char buffer[BUFFER_CHAR_LIMIT];
+                char name[DRAW_NAME_LIMIT];
+                size_t x, y;
+                double chance;
+
+                solver_update(g_rules.solver);
+                grid_log_clear(grid);
+
+                switch(solver_hint(g_rules.solver, &x, &y))
+                {
+                    case SAFE:
+                        draw_row_name(y, name);
+                        sprintf(buffer, "Podpowiedz: %zu%s jest bezpieczne.", x + 1, name);
+                        break;
+                    case MINED:
+                        draw_row_name(y, name);
+                        sprintf(buffer, "Podpowiedz: na %zu%s jest mina.", x + 1, name);
+                        break;
+                    default:
+                        /* The least risky tile then */
+                        if(odds_compute(g_rules.odds) == EXIT_SUCCESS && (chance = odds_safest(g_rules.odds, &x, &y)) >= 0)
+                        {
+                            draw_row_name(y, name);
+                            sprintf(buffer, "Brak pewnego ruchu, najbezpieczniej: %zu%s (mina: %.0f%%).", x + 1, name, chance * 100);
+                        }
+                        else
+                            sprintf(buffer, "Brak pewnego ruchu.");
+                        break;
+                }
+
+                draw_label(buffer, LOCATION_LABEL_X, LOCATION_LABEL_Y, INFOR_WAIT_TIME_S);
+                continue;
+            }
+
+            /* Overview, drawn at the loop's start */
+            if(move->reveal == 6)
+            {
+                draw_overview();
+                continue;
+            }
+
+            /* View, drawn at the loop's start */
+            if(move->reveal == 5)
+            {
+                if(move->dir != DIR_NONE)
+                    draw_pan(move->dir);
+                else if(move->col > 0 && move->col <= grid->cols && move->row > 0 && move->row <= grid->rows)
+                    draw_center(move->col - 1, move->row - 1);
+                else
+                    draw_label("Niewlasciwy widok.", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
+
+                continue;
+            }
+
             /* Mode */
-            if(move->reveal == (size_t) -1)
+            if(move->reveal == (size_t) -1 || move->reveal == 2)
             {
 
                 if(g_rules.move == stdin)
@@ -270,22 +375,40 @@ void game_loop(void)
 
             /* Executing the move */
 
-            /* Reveal and adding points */
+            /* Reveal (or chord) and adding points */
             size_t revealed = 0;
 
             if(move->reveal)
             {
-                revealed = grid_reveal(grid, move->col - 1, move->row - 1);
+                /* 1st reveal, choosing a board that needs no guess */
+                /* (its seed is kept, the board can be played again) */
+                if(g_rules.no_guess && grid->pending && move->reveal == 1)
+                {
+                    char buffer[BUFFER_CHAR_LIMIT] = "Nie znaleziono planszy bez zgadywania.";
 
-                /* Updating the grid */
-                draw_grid();
+                    /* Limited, a board is played anyway */
+                    draw_label("Szukanie planszy bez zgadywania...", LOCATION_LABEL_X, LOCATION_LABEL_Y, 0);
 
-                /* Valid points */
-                if(revealed < (size_t) -1)
-                    g_rules.score += revealed * (size_t) g_rules.diff;
+                    if(solver_no_guess(grid, move->col - 1, move->row - 1, 0, GAME_NO_GUESS_TIME_S) == EXIT_SUCCESS)
+                    {
+                        g_rules.seed = grid->seed;
+                        sprintf(buffer, "Plansza bez zgadywania, ziarno: %llu.", (unsigned long long) g_rules.seed);
+                    }
+
+                    draw_label(buffer, LOCATION_LABEL_X, LOCATION_LABEL_Y, INFOR_WAIT_TIME_S);
+                }
+
+                if(move->reveal == 3)
+                    revealed = grid_chord(grid, move->col - 1, move->row - 1);
+                else
+                    revealed = grid_reveal(grid, move->col - 1, move->row - 1);
+
+                /* Updating the grid, once per move */
+                draw_show(move->col - 1, move->row - 1);
+                draw_grid();
 
                 /* Mine - GAME OVER */
-                else if(revealed == (size_t) -1)
+                if(revealed == (size_t) -1)
                 {
                     g_rules.state = LOSER;
                     game_end();
@@ -294,55 +417,184 @@ void game_loop(void)
 
                 /* If all non-mine tiles have been revealed */
                 /* GAME WON */
-                for(size_t y = 0; y < grid->rows; ++y)
+                if(grid_won(grid))
                 {
-                    for(size_t x = 0; x < grid->cols; ++x)
-                    {
-                        if(grid_at(grid, x, y)->up == REVEALED ||
-                        grid_at(grid, x, y)->lo == MINE)
-                        {}
-                        else
-                            goto END;
-                    }
-                }  
-
-                /* GAME WON */
-                g_rules.state = WINNER;
-                game_end();
-                return;  
-
-                /* Still goin' */
-                END:;
+                    g_rules.state = WINNER;
+                    game_end();
+                    return;
+                }
             }
 
             /* Flag */
             else
             {
-                if(grid_at(grid, move->col - 1, move->row - 1)->up == FLAG)
-                    grid_at(grid, move->col - 1, move->row - 1)->up = UNREVEALED;
-
-                else if(grid_at(grid, move->col - 1, move->row - 1)->up == UNREVEALED)
-                    grid_at(grid, move->col - 1, move->row - 1)->up = FLAG;
+                grid_flag(grid, move->col - 1, move->row - 1);
 
                 /* Updating the grid */
+                draw_show(move->col - 1, move->row - 1);
                 draw_grid();
             }
+
+            /* The solver reads the changes as they come, */
+            /* so the log never grows past one move       */
+            solver_update(g_rules.solver);
+            grid_log_clear(grid);
         }   
     }
 }
 
+/* The board editor loop.
+ * Used instead of game_loop.
+ */
+void game_edit(void)
+{
+    /* Alias */
+    grid_t *grid = g_rules.grid;
+
+    /* Everything is visible while editing */
+    for(size_t y = 0; y < grid->rows; ++y)
+    {
+        tile_t *row = grid_row(grid, y);
+
+        for(size_t x = 0; x < grid->cols; ++x)
+            tile_set_up(&row[x], REVEALED);
+    }
+
+    grid->safe_left = 0;
+    grid_log_reset(grid);
+
+    /* Drawing the grid */
+    draw_grid();
+
+    while(true)
+    {
+        char buffer[BUFFER_CHAR_LIMIT];
+
+        /* After a resize or a moved view */
+        draw_grid();
+
+        sprintf(buffer, "Miny: %zu", grid->mines);
+        draw_label(buffer, LOCATION_SCORE_X, LOCATION_SCORE_Y, 0);
+
+        /* Getting the input */
+        char *in = draw_finput(g_rules.move, "Edycja (m<kol><wiersz> / z / exit): ", LOCATION_INPUT_X, LOCATION_INPUT_Y);
+
+        /* Bad input */
+        if(! in)
+        {
+            draw_label("Blad krytyczny, konczenie...", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
+            exit(EXIT_FAILURE);
+        }
+
+        /* Input ended (move file) or empty */
+        if(strlen(in) == 0)
+        {
+            if(g_rules.move != stdin)
+                exit(EXIT_SUCCESS);
+
+            continue;
+        }
+
+        if(strstr(in, "exit"))
+        {
+            /* Exit */
+            exit(EXIT_SUCCESS);
+        }
+
+        /* Saving */
+        if(tolower(in[0]) == 'z')
+        {
+            draw_keys(false);
+            char *name = draw_input("Nazwa pliku: ", LOCATION_INPUT_X, LOCATION_INPUT_Y);
+            draw_keys(true);
+
+            if(! name || strlen(name) == 0 || grid_save_text(grid, name))
+                draw_label("Nie mozna zapisac planszy.", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
+            else
+                draw_label("Zapisano.", LOCATION_LABEL_X, LOCATION_LABEL_Y, INFOR_WAIT_TIME_S);
+
+            continue;
+        }
+
+        move_t *move = game_input(in);
+
+        if(! move)
+        {
+            draw_label("Blad krytyczny, konczenie...", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
+            exit(EXIT_FAILURE);
+        }
+
+        /* Overview, drawn at the loop's start */
+        if(move->reveal == 6)
+        {
+            draw_overview();
+            continue;
+        }
+
+        /* View, drawn at the loop's start */
+        if(move->reveal == 5)
+        {
+            if(move->dir != DIR_NONE)
+                draw_pan(move->dir);
+            else if(move->col > 0 && move->col <= grid->cols && move->row > 0 && move->row <= grid->rows)
+                draw_center(move->col - 1, move->row - 1);
+            else
+                draw_label("Niewlasciwy widok.", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
+
+            continue;
+        }
+
+        /* Only mines here */
+        if(move->reveal != 2)
+        {
+            draw_label("Nieznany typ ruchu.", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
+            continue;
+        }
+
+        if(move->row > grid->rows || move->row == 0 || move->col > grid->cols || move->col == 0)
+        {
+            draw_label("Niewlasciwy indeks.", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
+            continue;
+        }
+
+        /* Toggling the mine, only its neighbourhood changes */
+        if(! grid_clear_mine(grid, move->col - 1, move->row - 1))
+            grid_set_mine(grid, move->col - 1, move->row - 1);
+
+        /* Updating the grid */
+        draw_show(move->col - 1, move->row - 1);
+        draw_grid();
+    }
+}
+
 /* Ends the game.
  */
 void game_end(void)
 {
+    char buffer[BUFFER_CHAR_LIMIT];
+
+    /* Board metrics, once: points for the 3BV */
+    /* revealed (a lucky opening is a single   */
+    /* click), a bonus for the speed if won    */
+    if(stats_compute(g_rules.grid, _game_now() - g_rules.start, &g_rules.stats) == EXIT_SUCCESS)
+    {
+        g_rules.score = g_rules.stats.bbbv_done * (size_t) g_rules.diff;
+
+        if(g_rules.state == WINNER)
+            g_rules.score += (size_t) (g_rules.stats.bbbv_s * GAME_SPEED_BONUS) * (size_t) g_rules.diff;
+    }
+
     /* Message */
     if(g_rules.state == WINNER)
-        draw_label("Wygrana!", LOCATION_LABEL_X, LOCATION_LABEL_Y, INFOR_WAIT_TIME_S);
+        sprintf(buffer, "Wygrana! 3BV: %zu  3BV/s: %.2f  Wynik: %lu", g_rules.stats.bbbv, g_rules.stats.bbbv_s, g_rules.score);
     else
-        draw_label("Przegrana!", LOCATION_LABEL_X, LOCATION_LABEL_Y, INFOR_WAIT_TIME_S);
+        sprintf(buffer, "Przegrana! Wynik: %lu", g_rules.score);
+
+    draw_label(buffer, LOCATION_LABEL_X, LOCATION_LABEL_Y, INFOR_WAIT_TIME_S);
 
     /* Delete the grid */
     cls();
+    draw_keys(false);
 
     /* Ask for the name only if score > 0 */
     /* Save the score */
@@ -351,7 +603,7 @@ void game_end(void)
         /* Get the name */
         char *name = draw_input("Wprowadz swoje imie: ", LOCATION_INPUT_X, LOCATION_INPUT_Y);
 
-        if(lead_add(name, g_rules.score))
+        if(lead_add(name, g_rules.score, (g_rules.state == WINNER) ? g_rules.stats.bbbv_s : 0))
         {
             /* Oops.. */
             draw_label("Nie mozna zapisac wyniku, konczenie...", LOCATION_LABEL_X, LOCATION_LABEL_Y, ERROR_WAIT_TIME_S);
@@ -377,7 +629,7 @@ void game_end(void)
             if(! list[i].name || strlen(list[i].name) == 0)
                 continue;
 
-            printf("%zu. %s %*zu\n", pos++, list[i].name, 20, list[i].score);
+            printf("%zu. %s %*zu %8.2f 3BV/s\n", pos++, list[i].name, 20, list[i].score, list[i].rate);
         }
     }
 
@@ -416,24 +668,34 @@ move_t *game_input(char *str)
     for(size_t i = 0; i < strlen(str); ++i)
         str[i] = tolower(str[i]);
 
-    /* Deleting all spaces */
+    /* Deleting all spaces (the null moves too, */
+    /* the next character is checked again)    */
     for(size_t i = 0; i < strlen(str); ++i)
     {
         if(str[i] == ' ')
         {
-            for(size_t j = i; j < strlen(str) - 1; ++j)
-                str[j] = str[j + 1];
+            memmove(&str[i], &str[i + 1], strlen(str) - i);
+            --i;
         }
     }
 
     /* Getting data */
 
     /* Move type */
-    move->reveal = (str[0] == 'r') ? true : (str[0] == 'f') ? false : (size_t) -1;
+    move->reveal = (str[0] == 'r') ? true : (str[0] == 'f') ? false : (str[0] == 'm') ? 2 : (str[0] == 'c') ? 3 : (str[0] == 'p') ? 4 : (str[0] == 'w') ? 5 : (str[0] == 'o') ? 6 : (size_t) -1;
+    move->dir = DIR_NONE;
     str = str + 1;
 
-    if(move->reveal == (size_t) -1)
+    /* No tile given */
+    if(move->reveal == (size_t) -1 || move->reveal == 4 || move->reveal == 6)
+        return move;
+
+    /* View moved by a direction (gora, dol, lewo, prawo) */
+    if(move->reveal == 5 && isalpha(str[0]))
+    {
+        move->dir = (str[0] == 'g') ? UP : (str[0] == 'd') ? DOWN : (str[0] == 'l') ? LEFT : (str[0] == 'p') ? RIGHT : DIR_NONE;
         return move;
+    }
 
     /* Column (1, 2, 3...) */
     size_t i = 0;
@@ -459,11 +721,16 @@ move_t *game_input(char *str)
     /* Removing the null */
     str[i] = tmp;
 
-    /* Row (a, b, c... z) */
+    /* Row (a, b, c... z, aa, ab...) */
     while(! isalpha(str[i]) && i < strlen(str))
         ++i;
 
-    move->row = isalpha(str[i]) ? (size_t)(str[i] - 'a' + 1) : (size_t) -1;
+    if(! isalpha(str[i]))
+        return move;
+
+    /* Too long a name is out of the grid */
+    for(move->row = 0; isalpha(str[i]) && move->row <= GRID_MAX_HEIGHT; ++i)
+        move->row = move->row * 26 + (size_t)(str[i] - 'a' + 1);
 
     return move;
 }
\ No newline at end of file
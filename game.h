@@ -13,7 +13,7 @@
 #define BUFFER_CHAR_LIMIT           128
 #define LEADERBOARD_CNT             5
 
-#define LOCATION_GRID_X             4
+#define LOCATION_GRID_X             7
 #define LOCATION_GRID_Y             5
 #define LOCATION_INPUT_X            2
 #define LOCATION_INPUT_Y            0
@@ -22,14 +22,25 @@
 #define LOCATION_LABEL_X            2
 #define LOCATION_LABEL_Y            3
 
+#define GAME_SAFE_OPENING           (1 << 8)    /* Mines placed after 1st move */
+#define GAME_EDITOR                 (1 << 9)    /* Board editing instead of game */
+#define GAME_NO_GUESS               (1 << 10)   /* Board won without guessing (with GAME_SAFE_OPENING) */
+
+#define GAME_SPEED_BONUS            10          /* Points per 3BV/s on a win */
+#define GAME_NO_GUESS_TIME_S        5.0         /* Longest search for a board with no guess */
+
 
 #include "draw.h"
 #include "grid.h"
 #include "leaderboard.h"
+#include "odds.h"
+#include "solver.h"
+#include "stats.h"
 #include "terminal.h"
 
 #include <ctype.h>
 #include <stdbool.h>
+#include <time.h>
 #include <unistd.h>
 
 
@@ -64,11 +75,17 @@ typedef struct _sap_rule_t
     size_t          mines;
 
     unsigned long   score;
-    unsigned int    seed;
+    uint64_t        seed;
     gamestate_t     state;
     FILE            *move;
+    bool            no_guess;   /* Mines placed for no guessing */
+
+    double          start;      /* Time of the game's start (s) */
+    stats_t         stats;      /* Board metrics, at the end        */
 
     grid_t          *grid;
+    solver_t        *solver;    /* Hints, follows the grid */
+    odds_t          *odds;      /* Chances, if no sure hint */
 
 } gamerule_t;
 
@@ -78,7 +95,8 @@ typedef struct _sap_move_t
 {
     size_t          row;
     size_t          col;
-    int             reveal;     /* 0 - flag, 1 - reveal */
+    int             reveal;     /* 0 - flag, 1 - reveal, 2 - mine (editor), 3 - chord, 4 - hint, 5 - view, 6 - overview */
+    dir_t           dir;        /* View moved this way, DIR_NONE if to the tile */
 
 } move_t;
 
@@ -89,17 +107,22 @@ static gamerule_t g_rules;
 
 /* Starts the game.
  *
- *  settings    - the game options
+ *  settings    - the game options (DRAW_* and GAME_* constants)
  *  filegrid    - file to read the grid from (can be NULL)
  *  filemove    - file to read movement from (can be NULL)
  *  seed        - seed value
  */
-void        game_init(int settings, const char *filegrid, const char *filemove, unsigned int seed);
+void        game_init(int settings, const char *filegrid, const char *filemove, uint64_t seed);
 
 /* The game loop.
  */
 void        game_loop(void);
 
+/* The board editor loop.
+ * Used instead of game_loop.
+ */
+void        game_edit(void);
+
 /* Ends the game.
  */
 void        game_end(void);
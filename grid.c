@@ -8,20 +8,90 @@
 #include "grid.h"
 
 
-/* Creates new, randomly filled grid with given settings.
+/* Position standing in for a skipped one. */
+static size_t _grid_swap(size_t pos, const size_t *from, const size_t *to, size_t nswap)
+{
+    for(size_t k = 0; k < nswap; ++k)
+        if(from[k] == pos)
+            return to[k];
+
+    return pos;
+}
+
+/* Sets the lower layer of 'count' distinct
+ * random tiles to 'lo'. None of the tiles may
+ * hold 'lo' beforehand. Floyd's sampling: one
+ * random number per chosen tile, no buffer,
+ * the grid itself marks the chosen ones.
  *
- *  rows    - number of rows
- *  cols    - number of columns
- *  mines   - number of mines
- *  seed    - optional seed, if NULL the time() function will be used
+ *  skip    - ascending positions never chosen (up to 9)
+ *  nskip   - no of the positions
+ */
+static void _grid_scatter(grid_t *grid, size_t count, lo_layer_t lo, const size_t *skip, size_t nskip)
+{
+    assert(nskip <= 9);
+
+    const size_t size = grid->rows * grid->cols - nskip;
+
+    /* Skipped positions below 'size' stand
+     * for the free ones at or above it */
+    size_t from[9], to[9], nswap = 0;
+
+    for(size_t i = 0, t = size; i < nskip; ++i)
+    {
+        if(skip[i] >= size)
+            continue;
+
+        /* Next position above 'size' not skipped */
+        /* (one pass, the positions are ascending) */
+        for(size_t k = 0; k < nskip; ++k)
+            if(skip[k] == t)
+                ++t;
+
+        from[nswap] = skip[i];
+        to[nswap++] = t++;
+    }
+
+    for(size_t j = size - count; j < size; ++j)
+    {
+        size_t pos = (size_t) rng_below(&grid->rng, j + 1);
+
+        /* Already taken, 'j' itself cannot be */
+        if(tile_lo(grid->tiles[_grid_swap(pos, from, to, nswap)]) == lo)
+            pos = j;
+
+        tile_set_lo(&grid->tiles[_grid_swap(pos, from, to, nswap)], lo);
+    }
+}
+
+/* Places grid->mines mines at random.
  *
- *  Returns NULL if failed, valid pointer otherwise.
+ *  skip    - ascending positions left without a mine (up to 9)
+ *  nskip   - no of the positions
  */
-grid_t *new_grid(size_t rows, size_t cols, size_t mines, unsigned int seed)
+static void _grid_place(grid_t *grid, const size_t *skip, size_t nskip)
 {
-    /* Checking integer values */
-    assert(rows > 0 && cols > 0 && mines < rows * cols);
+    const size_t size = grid->rows * grid->cols - nskip;
+
+    /* Dense grid: filling it with mines
+     * and choosing the safe tiles instead */
+    if(grid->mines > size / 2)
+    {
+        for(size_t i = 0; i < grid->rows * grid->cols; ++i)
+            tile_set_lo(&grid->tiles[i], MINE);
+
+        for(size_t i = 0; i < nskip; ++i)
+            tile_set_lo(&grid->tiles[skip[i]], D0);
+
+        _grid_scatter(grid, size - grid->mines, D0, skip, nskip);
+    }
+    else
+        _grid_scatter(grid, grid->mines, MINE, skip, nskip);
+}
 
+/* Allocates an empty, unrevealed grid. */
+static grid_t *_grid_alloc(size_t rows, size_t cols)
+{
     grid_t *g = NULL;
 
     /* Memory allocation + checking */
@@ -32,280 +102,1333 @@ grid_t *new_grid(size_t rows, size_t cols, size_t mines, unsigned int seed)
 
     g->rows = rows;
     g->cols = cols;
+    g->mines = 0;
+    g->safe_left = rows * cols;
+    g->pending = false;
+
+    /* Openings are labeled on the first need */
+    g->region = NULL;
+    g->open_start = NULL;
+    g->open_tiles = NULL;
+    g->openings = 0;
+    g->start_cap = 0;
+    g->tiles_cap = 0;
+    g->regions_valid = false;
+    g->regions_tried = false;
+
+    /* Nothing changed yet */
+    g->log = NULL;
+    g->log_len = 0;
+    g->log_cap = 0;
+    g->log_base = 0;
 
     /* Actual grid allocation + checking */
-    if((g->tiles = (tile_t **) malloc(sizeof(tile_t *) * cols)) == NULL)
+    /* Zeroed tile is unrevealed and empty */
+    if((g->tiles = (tile_t *) calloc(rows * cols, sizeof(tile_t))) == NULL)
     {
         free(g);
         return NULL;
     }
 
-    for(size_t x = 0; x < cols; ++x)
+    /* Flood fill stack, grows if needed */
+    g->work_cap = rows + cols;
+    if((g->work = (size_t *) malloc(sizeof(size_t) * g->work_cap)) == NULL)
+    {
+        free(g->tiles);
+        free(g);
+        return NULL;
+    }
+
+    /* No flags yet */
+    if((g->flags_near = (uint8_t *) calloc(rows * cols, sizeof(uint8_t))) == NULL)
+    {
+        free(g->work);
+        free(g->tiles);
+        free(g);
+        return NULL;
+    }
+
+    return g;
+}
+
+/* Mine mask of a row: 1 for a mine, 0 otherwise,
+ * written to mask[1 ... cols] (mask[0] and
+ * mask[cols + 1] stay zero).
+ */
+static void _grid_mask_row(const grid_t *grid, size_t y, uint8_t *mask)
+{
+    const tile_t *row = grid_row(grid, y);
+
+    for(size_t x = 0; x < grid->cols; ++x)
+        mask[x + 1] = (uint8_t) (tile_lo(row[x]) == MINE);
+}
+
+/* Writes the lower layer of 'cols' tiles from
+ * the padded masks of the row (mc) and the rows
+ * above (mu) and below (md) it.
+ */
+typedef void (*_grid_kernel_t)(const uint8_t *mu, const uint8_t *mc, const uint8_t *md, tile_t *row, size_t cols);
+
+/* Box sum for the tiles [from, cols). */
+static void _grid_box_scalar_from(const uint8_t *mu, const uint8_t *mc, const uint8_t *md, tile_t *row, size_t from, size_t cols)
+{
+    for(size_t x = from; x < cols; ++x)
+    {
+        if(mc[x + 1])
+        {
+            tile_set_lo(&row[x], MINE);
+            continue;
+        }
+
+        int tile_val = mu[x] + mu[x + 1] + mu[x + 2] +
+                       mc[x]             + mc[x + 2] +
+                       md[x] + md[x + 1] + md[x + 2];
+
+        /* Giving 0 - 8 value */
+        tile_set_lo(&row[x], (lo_layer_t) tile_val);
+    }
+}
+
+/* Box sum, one tile at a time. */
+static void _grid_box_scalar(const uint8_t *mu, const uint8_t *mc, const uint8_t *md, tile_t *row, size_t cols)
+{
+    _grid_box_scalar_from(mu, mc, md, row, 0, cols);
+}
+
+#ifdef GRID_SIMD_X86
+
+/* Box sum, 16 tiles at a time. */
+__attribute__((target("sse2")))
+static void _grid_box_sse2(const uint8_t *mu, const uint8_t *mc, const uint8_t *md, tile_t *row, size_t cols)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i mine = _mm_set1_epi8((char) MINE);
+    const __m128i up = _mm_set1_epi8((char) ~TILE_LO_MASK);
+
+    size_t x = 0;
+
+    for(; x + 16 <= cols; x += 16)
+    {
+        __m128i sum = _mm_add_epi8(_mm_loadu_si128((const __m128i *) (mu + x)),
+                                   _mm_loadu_si128((const __m128i *) (mu + x + 1)));
+        sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *) (mu + x + 2)));
+        sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *) (mc + x)));
+        sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *) (mc + x + 2)));
+        sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *) (md + x)));
+        sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *) (md + x + 1)));
+        sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *) (md + x + 2)));
+
+        /* Mines keep MINE, others get the sum */
+        __m128i is_mine = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (mc + x + 1)), one);
+        __m128i lo = _mm_or_si128(_mm_and_si128(is_mine, mine), _mm_andnot_si128(is_mine, sum));
+
+        /* Upper layer is kept */
+        __m128i tiles = _mm_and_si128(_mm_loadu_si128((const __m128i *) (row + x)), up);
+        _mm_storeu_si128((__m128i *) (row + x), _mm_or_si128(tiles, lo));
+    }
+
+    _grid_box_scalar_from(mu, mc, md, row, x, cols);
+}
+
+/* Box sum, 32 tiles at a time. */
+__attribute__((target("avx2")))
+static void _grid_box_avx2(const uint8_t *mu, const uint8_t *mc, const uint8_t *md, tile_t *row, size_t cols)
+{
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i mine = _mm256_set1_epi8((char) MINE);
+    const __m256i up = _mm256_set1_epi8((char) ~TILE_LO_MASK);
+
+    size_t x = 0;
+
+    for(; x + 32 <= cols; x += 32)
+    {
+        __m256i sum = _mm256_add_epi8(_mm256_loadu_si256((const __m256i *) (mu + x)),
+                                      _mm256_loadu_si256((const __m256i *) (mu + x + 1)));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *) (mu + x + 2)));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *) (mc + x)));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *) (mc + x + 2)));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *) (md + x)));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *) (md + x + 1)));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *) (md + x + 2)));
+
+        /* Mines keep MINE, others get the sum */
+        __m256i is_mine = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (mc + x + 1)), one);
+        __m256i lo = _mm256_blendv_epi8(sum, mine, is_mine);
+
+        /* Upper layer is kept */
+        __m256i tiles = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (row + x)), up);
+        _mm256_storeu_si256((__m256i *) (row + x), _mm256_or_si256(tiles, lo));
+    }
+
+    /* Rest (< 32 tiles) */
+    _grid_box_sse2(mu + x, mc + x, md + x, row + x, cols - x);
+}
+
+#endif
+
+/* Chooses the box sum the CPU can run. */
+static _grid_kernel_t _grid_kernel(void)
+{
+#ifdef GRID_SIMD_X86
+    if(__builtin_cpu_supports("avx2"))
+        return _grid_box_avx2;
+
+    if(__builtin_cpu_supports("sse2"))
+        return _grid_box_sse2;
+#endif
+
+    return _grid_box_scalar;
+}
+
+/* complete_grid without any buffers,
+ * used if the masks cannot be allocated.
+ */
+static void _grid_complete_scalar(grid_t *grid)
+{
+    /* Calculations for each tile, row by row */
+    /* U - Up, D - Down (neighbouring rows) */
+    for(size_t y = 0; y < grid->rows; ++y)
+    {
+        const tile_t *row_u = (y > 0) ? grid_row(grid, y - 1) : NULL;
+        const tile_t *row_d = grid_row(grid, y + 1);
+        tile_t *row = grid_row(grid, y);
+
+        for(size_t x = 0; x < grid->cols; ++x)
+        {
+            int tile_val = 0;
+
+            /* Skip if mine */
+            if(tile_lo(row[x]) == MINE)
+                continue;
+
+            /* Columns x - 1 ... x + 1, clipped */
+            size_t xl = (x > 0) ? x - 1 : x;
+            size_t xr = (x + 1 < grid->cols) ? x + 1 : x;
+
+            for(size_t i = xl; i <= xr; ++i)
+            {
+                if(row_u && tile_lo(row_u[i]) == MINE)
+                    ++tile_val;
+
+                if(row_d && tile_lo(row_d[i]) == MINE)
+                    ++tile_val;
+
+                if(i != x && tile_lo(row[i]) == MINE)
+                    ++tile_val;
+            }
+
+            /* Giving 0 - 8 value */
+            tile_set_lo(&row[x], (lo_layer_t) tile_val);
+        }
+    }
+}
+
+/* Notes a changed tile in the grid's log.
+ * If the log cannot grow, it is reset, so
+ * its readers look at the whole grid.
+ */
+static void _grid_log(grid_t *grid, size_t pos)
+{
+    if(grid->log_len == grid->log_cap)
+    {
+        size_t cap = grid->log_cap ? 2 * grid->log_cap : 64;
+        size_t *temp = (size_t *) realloc(grid->log, sizeof(size_t) * cap);
+
+        if(! temp)
+        {
+            grid_log_reset(grid);
+            return;
+        }
+
+        grid->log = temp;
+        grid->log_cap = cap;
+    }
+
+    grid->log[grid->log_len++] = pos;
+}
+
+/* Doubles grid->open_tiles (the first
+ * time it gets one entry per tile).
+ */
+static int _grid_list_grow(grid_t *grid)
+{
+    size_t cap = grid->tiles_cap ? 2 * grid->tiles_cap : grid->rows * grid->cols + 8;
+    uint32_t *temp = (uint32_t *) realloc(grid->open_tiles, sizeof(uint32_t) * cap);
+    if(! temp)
+        return EXIT_FAILURE;
+
+    grid->open_tiles = temp;
+    grid->tiles_cap = cap;
+
+    return EXIT_SUCCESS;
+}
+
+/* Labels the openings: every group of
+ * connected empty tiles with its numbered
+ * border, listed one after another in
+ * grid->open_tiles. The list itself is
+ * the queue of the search, so each tile
+ * is looked at once per opening.
+ */
+static void _grid_label(grid_t *grid)
+{
+    const size_t size = grid->rows * grid->cols;
+
+    /* Not again until the mines change */
+    grid->regions_tried = true;
+    grid->regions_valid = false;
+    grid->openings = 0;
+
+    /* Labels would not fit */
+    if(size >= UINT32_MAX)
+        return;
+
+    if(! grid->region && ! (grid->region = (uint32_t *) malloc(sizeof(uint32_t) * size)))
+        return;
+
+    memset(grid->region, 0, sizeof(uint32_t) * size);
+
+    size_t used = 0;
+
+    /* 32-bit positions, quicker to divide */
+    const uint32_t cols = (uint32_t) grid->cols;
+    const uint32_t rows = (uint32_t) grid->rows;
+
+    for(uint32_t t = 0; t < size; ++t)
+    {
+        if(tile_lo(grid->tiles[t]) != D0 || grid->region[t])
+            continue;
+
+        /* Room for this opening's end too */
+        if(grid->openings + 2 > grid->start_cap)
+        {
+            size_t cap = grid->start_cap ? 2 * grid->start_cap : 64;
+            size_t *temp = (size_t *) realloc(grid->open_start, sizeof(size_t) * cap);
+            if(! temp)
+                return;
+
+            grid->open_start = temp;
+            grid->start_cap = cap;
+        }
+
+        const uint32_t id = (uint32_t) ++grid->openings;
+        size_t head = used;
+
+        grid->open_start[id - 1] = used;
+
+        /* Empty tiles are labeled for good, */
+        /* numbered ones only mark the last  */
+        /* opening listing them              */
+        if(used + 1 > grid->tiles_cap && _grid_list_grow(grid) != EXIT_SUCCESS)
+            return;
+
+        grid->region[t] = id;
+        grid->open_tiles[used++] = t;
+
+        for(; head < used; ++head)
+        {
+            const uint32_t pos = grid->open_tiles[head];
+            if(tile_lo(grid->tiles[pos]) != D0)
+                continue;
+
+            /* Room for all the neighbours */
+            if(used + 8 > grid->tiles_cap && _grid_list_grow(grid) != EXIT_SUCCESS)
+                return;
+
+            uint32_t *list = grid->open_tiles;
+            uint32_t *region = grid->region;
+
+            const uint32_t x = pos % cols;
+            const uint32_t y = pos / cols;
+
+            /* Inside, no bounds to check */
+            if(x > 0 && y > 0 && x + 1 < cols && y + 1 < rows)
+            {
+                const uint32_t near[8] =
+                {
+                    pos - cols - 1, pos - cols, pos - cols + 1, pos - 1,
+                    pos + 1, pos + cols - 1, pos + cols, pos + cols + 1
+                };
+
+                for(int k = 0; k < 8; ++k)
+                {
+                    /* Other openings' empty tiles cannot touch this one */
+                    if(region[near[k]] != id)
+                    {
+                        region[near[k]] = id;
+                        list[used++] = near[k];
+                    }
+                }
+
+                continue;
+            }
+
+            for(uint32_t sy = (y > 0 ? y - 1 : y); sy <= y + 1 && sy < rows; ++sy)
+            {
+                for(uint32_t sx = (x > 0 ? x - 1 : x); sx <= x + 1 && sx < cols; ++sx)
+                {
+                    const uint32_t next = sy * cols + sx;
+
+                    if(region[next] != id)
+                    {
+                        region[next] = id;
+                        list[used++] = next;
+                    }
+                }
+            }
+        }
+
+        grid->open_start[id] = used;
+    }
+
+    grid->regions_valid = true;
+}
+
+/* Drops the openings' labels, they do not
+ * match the mines any more. The memory
+ * goes back until they are needed again.
+ */
+static void _grid_unlabel(grid_t *grid)
+{
+    free(grid->region);
+    free(grid->open_start);
+    free(grid->open_tiles);
+
+    grid->region = NULL;
+    grid->open_start = NULL;
+    grid->open_tiles = NULL;
+    grid->openings = 0;
+    grid->start_cap = 0;
+    grid->tiles_cap = 0;
+    grid->regions_valid = false;
+    grid->regions_tried = false;
+}
+
+/* complete_grid with the given box sum
+ * as the widest one.
+ */
+static void _grid_complete(grid_t *grid, _grid_kernel_t kernel)
+{
+    const size_t cols = grid->cols;
+
+    /* Mine masks of three rows (U - Up, C - Current, D - Down),
+     * one padding byte on each side */
+    uint8_t *mask = (uint8_t *) calloc(3 * (cols + 2), sizeof(uint8_t));
+    if(! mask)
+    {
+        /* No memory for the masks, slow way */
+        _grid_complete_scalar(grid);
+        _grid_unlabel(grid);
+        grid_log_reset(grid);
+        return;
+    }
+
+    uint8_t *mu = mask;
+    uint8_t *mc = mask + (cols + 2);
+    uint8_t *md = mask + 2 * (cols + 2);
+
+    _grid_mask_row(grid, 0, mc);
+
+    for(size_t y = 0; y < grid->rows; ++y)
+    {
+        /* Next row's mask, or none */
+        if(y + 1 < grid->rows)
+            _grid_mask_row(grid, y + 1, md);
+        else
+            memset(md, 0, cols + 2);
+
+        kernel(mu, mc, md, grid_row(grid, y), cols);
+
+        /* Shifting the masks up */
+        uint8_t *temp = mu;
+        mu = mc;
+        mc = md;
+        md = temp;
+    }
+
+    free(mask);
+
+    _grid_unlabel(grid);
+    grid_log_reset(grid);
+}
+
+/* Reveals a whole opening from its list.
+ * Returns (size_t) -1 if one of its empty
+ * tiles is flagged, the flood fill stops
+ * at flags, the list could not.
+ */
+static size_t _grid_reveal_opening(grid_t *grid, size_t opening)
+{
+    const uint32_t *first = grid->open_tiles + grid->open_start[opening];
+    const uint32_t *last = grid->open_tiles + grid->open_start[opening + 1];
+
+    for(const uint32_t *t = first; t < last; ++t)
+        if(grid->tiles[*t] == (tile_t) ((unsigned) FLAG << TILE_UP_SHIFT))
+            return (size_t) -1;
+
+    size_t count_revealed = 0;
+
+    for(const uint32_t *t = first; t < last; ++t)
+    {
+        if(tile_up(grid->tiles[*t]) != UNREVEALED)
+            continue;
+
+        tile_set_up(&grid->tiles[*t], REVEALED);
+        _grid_log(grid, *t);
+        ++count_revealed;
+    }
+
+    grid->safe_left -= count_revealed;
+
+    return count_revealed;
+}
+
+/* Stores a 64-bit value, little-endian. */
+static void _grid_put64(uint8_t *dst, uint64_t value)
+{
+    for(int i = 0; i < 8; ++i)
+        dst[i] = (uint8_t) (value >> (8 * i));
+}
+
+/* Reads a 64-bit value, little-endian. */
+static uint64_t _grid_get64(const uint8_t *src)
+{
+    uint64_t value = 0;
+
+    for(int i = 0; i < 8; ++i)
+        value |= (uint64_t) src[i] << (8 * i);
+
+    return value;
+}
+
+/* FNV-1a hash of the mine map. */
+static uint64_t _grid_checksum(const uint8_t *data, size_t size)
+{
+    uint64_t hash = 0xCBF29CE484222325u;
+
+    for(size_t i = 0; i < size; ++i)
+        hash = (hash ^ data[i]) * 0x100000001B3u;
+
+    return hash;
+}
+
+/* Eight lower layers for each byte of the
+ * map (bit i is tile i), made at compile
+ * time and read one tile per byte.
+ */
+#define _GRID_LUT_TILE(b, i)    ((((b) >> (i)) & 1) ? (tile_t) MINE : (tile_t) 0)
+#define _GRID_LUT_1(b)          { _GRID_LUT_TILE(b, 0), _GRID_LUT_TILE(b, 1), _GRID_LUT_TILE(b, 2), \
+                                  _GRID_LUT_TILE(b, 3), _GRID_LUT_TILE(b, 4), _GRID_LUT_TILE(b, 5), \
+                                  _GRID_LUT_TILE(b, 6), _GRID_LUT_TILE(b, 7) }
+#define _GRID_LUT_4(b)          _GRID_LUT_1(b), _GRID_LUT_1(b + 1), _GRID_LUT_1(b + 2), _GRID_LUT_1(b + 3)
+#define _GRID_LUT_16(b)         _GRID_LUT_4(b), _GRID_LUT_4(b + 4), _GRID_LUT_4(b + 8), _GRID_LUT_4(b + 12)
+#define _GRID_LUT_64(b)         _GRID_LUT_16(b), _GRID_LUT_16(b + 16), _GRID_LUT_16(b + 32), _GRID_LUT_16(b + 48)
+
+static const tile_t g_grid_lut[256][8] =
+{
+    _GRID_LUT_64(0), _GRID_LUT_64(64), _GRID_LUT_64(128), _GRID_LUT_64(192)
+};
+
+#undef _GRID_LUT_64
+#undef _GRID_LUT_16
+#undef _GRID_LUT_4
+#undef _GRID_LUT_1
+#undef _GRID_LUT_TILE
+
+/* Builds a grid from a binary board
+ * (see GRID_BIN_*) held in memory.
+ */
+static grid_t *_grid_from_binary(const uint8_t *data, size_t size)
+{
+    if(size < GRID_BIN_HEADER || memcmp(data, GRID_BIN_MAGIC, 4) != 0 ||
+       data[4] != GRID_BIN_VERSION)
+        return NULL;
+
+    const uint64_t rows = _grid_get64(data + 8);
+    const uint64_t cols = _grid_get64(data + 16);
+    const uint64_t mines = _grid_get64(data + 24);
+    const uint64_t seed = _grid_get64(data + 32);
+
+    if(rows == 0 || cols == 0 || rows > SIZE_MAX / cols || mines >= rows * cols)
+        return NULL;
+
+    /* Rows are padded to whole bytes */
+    const size_t stride = (size_t) (cols + 7) / 8;
+    const uint8_t *map = data + GRID_BIN_HEADER;
+
+    if((size - GRID_BIN_HEADER) / stride < rows || size - GRID_BIN_HEADER != stride * rows ||
+       _grid_checksum(map, stride * rows) != _grid_get64(data + 40))
+        return NULL;
+
+    grid_t *grid = _grid_alloc((size_t) rows, (size_t) cols);
+    if(! grid)
+        return NULL;
+
+    grid->seed = seed;
+    rng_seed(&grid->rng, (seed == 0) ? rng_time_seed() : seed);
+
+    size_t count = 0;
+
+    for(size_t y = 0; y < rows; ++y)
+    {
+        const uint8_t *bits = map + y * stride;
+        tile_t *row = grid_row(grid, y);
+        size_t x = 0;
+
+        for(; x + 8 <= cols; x += 8)
+        {
+            memcpy(&row[x], g_grid_lut[bits[x / 8]], 8);
+            count += (size_t) __builtin_popcount(bits[x / 8]);
+        }
+
+        for(; x < cols; ++x)
+        {
+            if((bits[x / 8] >> (x % 8)) & 1)
+            {
+                row[x] = (tile_t) MINE;
+                ++count;
+            }
+        }
+    }
+
+    if(count != mines)
+    {
+        del_grid(grid);
+        return NULL;
+    }
+
+    grid->mines = count;
+    grid->safe_left = (size_t) (rows * cols) - count;
+
+    complete_grid(grid);
+
+    return grid;
+}
+
+/* Loads a binary board, mapped into
+ * memory where possible.
+ */
+static grid_t *_grid_load_binary(const char *filename)
+{
+    grid_t *grid = NULL;
+
+#ifdef GRID_MMAP
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+        return NULL;
+
+    struct stat st;
+
+    if(fstat(fd, &st) == 0 && st.st_size >= GRID_BIN_HEADER)
+    {
+        void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if(data != MAP_FAILED)
+        {
+            grid = _grid_from_binary((const uint8_t *) data, (size_t) st.st_size);
+            munmap(data, (size_t) st.st_size);
+        }
+    }
+
+    close(fd);
+#else
+    FILE *file = fopen(filename, "rb");
+    if(! file)
+        return NULL;
+
+    long size = -1;
+    uint8_t *data = NULL;
+
+    if(fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= GRID_BIN_HEADER &&
+       fseek(file, 0, SEEK_SET) == 0 && (data = (uint8_t *) malloc((size_t) size)) &&
+       fread(data, 1, (size_t) size, file) == (size_t) size)
+        grid = _grid_from_binary(data, (size_t) size);
+
+    free(data);
+    fclose(file);
+#endif
+
+    return grid;
+}
+
+/* State of the text board parser. */
+typedef struct _sap_grid_text_t
+{
+    grid_t *grid;                           /* Made after 2 numbers     */
+    size_t rows;                            /* First number             */
+    size_t tokens;                          /* Numbers read so far      */
+    size_t x;                               /* Column of the mine       */
+    size_t x_line;                          /* Line of the column       */
+    size_t line;                            /* Current line, from 1     */
+    bool no_memory;                         /* Failed, but not the file */
+
+} _grid_text_t;
+
+/* Takes one number of a text board.
+ * Returns false if the number is bad.
+ */
+static bool _grid_text_token(_grid_text_t *st, size_t value)
+{
+    const size_t n = st->tokens++;
+
+    /* First line: rows, second: cols */
+    if(n == 0)
+        return (st->rows = value) > 0;
+
+    if(n == 1)
+    {
+        if(value == 0 || st->rows > SIZE_MAX / value)
+            return false;
+
+        if(! (st->grid = _grid_alloc(st->rows, value)))
+        {
+            /* Not the file's fault */
+            st->no_memory = true;
+            return false;
+        }
+
+        /* Mines do not come from a seed */
+        st->grid->seed = 0;
+        rng_seed(&st->grid->rng, rng_time_seed());
+
+        return true;
+    }
+
+    /* Next lines: 'x y' of the mines */
+    if(n % 2 == 0)
+    {
+        st->x = value;
+        st->x_line = st->line;
+
+        return value < st->grid->cols;
+    }
+
+    if(value >= st->grid->rows)
+        return false;
+
+    /* Same mine may be listed twice */
+    tile_t *tile = &st->grid->tiles[value * st->grid->cols + st->x];
+
+    if(*tile != (tile_t) MINE)
+    {
+        *tile = (tile_t) MINE;
+        ++st->grid->mines;
+    }
+
+    return true;
+}
+
+/* Parses a text board block by block.
+ * 'buf' holds the first 'len' bytes
+ * read already.
+ */
+static grid_t *_grid_load_text(FILE *file, char *buf, size_t len, size_t *line)
+{
+    _grid_text_t st = { .line = 1, };
+
+    size_t value = 0;
+    bool in_number = false;
+    bool ok = true;
+
+    do
+    {
+        for(size_t i = 0; i < len && ok; ++i)
+        {
+            const unsigned digit = (unsigned) (unsigned char) buf[i] - '0';
+
+            if(digit < 10)
+            {
+                /* Too long for size_t */
+                ok = value <= (SIZE_MAX - digit) / 10;
+
+                value = value * 10 + digit;
+                in_number = true;
+                continue;
+            }
+
+            if(in_number)
+            {
+                if(! (ok = _grid_text_token(&st, value)))
+                    break;
+
+                value = 0;
+                in_number = false;
+            }
+
+            if(buf[i] == '\n')
+                ++st.line;
+
+            else if(buf[i] != ' ' && buf[i] != '\t' && buf[i] != '\r')
+                ok = false;
+        }
+    }
+    while(ok && (len = fread(buf, 1, GRID_LOAD_BLOCK, file)) > 0);
+
+    /* Last number */
+    if(ok && in_number)
+        ok = _grid_text_token(&st, value);
+
+    /* Read error, no size or a lone 'x' */
+    if(ok && (ferror(file) || st.tokens < 2 || st.tokens % 2 != 0))
+    {
+        ok = false;
+
+        if(st.tokens % 2 != 0 && st.tokens > 2)
+            st.line = st.x_line;
+    }
+
+    if(! ok)
+    {
+        if(line)
+            *line = (st.no_memory || ferror(file)) ? 0 : st.line;
+
+        del_grid(st.grid);
+        return NULL;
+    }
+
+    st.grid->safe_left = st.grid->rows * st.grid->cols - st.grid->mines;
+    complete_grid(st.grid);
+
+    return st.grid;
+}
+
+
+/* Creates new, randomly filled grid with given settings.
+ *
+ *  rows    - number of rows
+ *  cols    - number of columns
+ *  mines   - number of mines
+ *  seed    - optional seed, if 0 a time based one is used (kept in grid->seed)
+ *
+ *  Returns NULL if failed, valid pointer otherwise.
+ */
+grid_t *new_grid(size_t rows, size_t cols, size_t mines, uint64_t seed)
+{
+    /* Checking integer values */
+    assert(rows > 0 && cols > 0 && mines < rows * cols);
+
+    grid_t *g = _grid_alloc(rows, cols);
+    if(! g)
+        return NULL;
+
+    g->mines = mines;
+    g->safe_left = (rows * cols) - mines;
+
+    /* Randomizing mines position */
+    g->seed = (seed == 0) ? rng_time_seed() : seed;
+    rng_seed(&g->rng, g->seed);
+
+    _grid_place(g, NULL, 0);
+
+    complete_grid(g);
+    return g;
+}
+
+/* Creates new grid with given settings,
+ * the mines are placed at the first reveal,
+ * away from the revealed tile and its
+ * neighbours (so it always opens an area).
+ *
+ *  rows    - number of rows
+ *  cols    - number of columns
+ *  mines   - number of mines
+ *  seed    - optional seed, if 0 a time based one is used (kept in grid->seed)
+ *
+ *  Returns NULL if failed, valid pointer otherwise.
+ */
+grid_t *new_grid_deferred(size_t rows, size_t cols, size_t mines, uint64_t seed)
+{
+    /* Checking integer values */
+    assert(rows > 0 && cols > 0 && mines < rows * cols);
+
+    grid_t *g = _grid_alloc(rows, cols);
+    if(! g)
+        return NULL;
+
+    g->mines = mines;
+    g->safe_left = (rows * cols) - mines;
+    g->pending = true;
+
+    g->seed = (seed == 0) ? rng_time_seed() : seed;
+    rng_seed(&g->rng, g->seed);
+
+    return g;
+}
+
+/* Makes the grid a new deferred one of the
+ * same size and mine count, keeping its
+ * memory. Readers of the log start over.
+ *
+ *  grid    - the grid
+ *  seed    - optional seed, if 0 a time based one is used (kept in grid->seed)
+ */
+void grid_reset(grid_t *grid, uint64_t seed)
+{
+    /* Pointer checking */
+    assert(grid);
+
+    const size_t size = grid->rows * grid->cols;
+
+    memset(grid->tiles, 0, sizeof(tile_t) * size);
+    memset(grid->flags_near, 0, sizeof(uint8_t) * size);
+
+    grid->safe_left = size - grid->mines;
+    grid->pending = true;
+
+    grid->seed = (seed == 0) ? rng_time_seed() : seed;
+    rng_seed(&grid->rng, grid->seed);
+
+    _grid_unlabel(grid);
+    grid_log_reset(grid);
+}
+
+/* Loads grid from file, either a binary
+ * board (see grid_save) or a text one:
+ * rows, cols, then 'x y' of each mine.
+ * Any white space separates the numbers,
+ * a mine listed twice counts once.
+ *
+ *  filename - the file name
+ *  line     - gets the line of the first bad entry
+ *             of a text board, 0 if the file was
+ *             not read at all (can be NULL)
+ */
+grid_t *grid_load(const char *filename, size_t *line)
+{
+    /* Pointer checking */
+    assert(filename);
+
+    if(line)
+        *line = 0;
+
+    FILE *file = fopen(filename, "rb");
+    if(! file)
+    {
+        /* Oops */
+        return NULL;
+    }
+
+    char *buf = (char *) malloc(GRID_LOAD_BLOCK);
+    if(! buf)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    grid_t *grid = NULL;
+    size_t len = fread(buf, 1, GRID_LOAD_BLOCK, file);
+
+    /* Binary board? */
+    if(len >= 4 && memcmp(buf, GRID_BIN_MAGIC, 4) == 0)
+    {
+        fclose(file);
+        free(buf);
+
+        return _grid_load_binary(filename);
+    }
+
+    grid = _grid_load_text(file, buf, len, line);
+
+    fclose(file);
+    free(buf);
+
+    return grid;
+}
+
+/* Completes lower layer of the grid
+ * based on the mine placement.
+ * Counts are a 3x3 box sum over a padded
+ * mine mask, done a row at a time
+ * (SSE2/AVX2 if the CPU supports it).
+ * Drops the openings' labels, grid_reveal
+ * makes them again when needed.
+ *
+ *  grid     - the grid
+ */
+void complete_grid(grid_t *grid)
+{
+    /* Pointer check */
+    assert(grid);
+
+    _grid_complete(grid, _grid_kernel());
+}
+
+/* Reveals the tiles starting with
+ * the specified one
+ *
+ *  grid    - the grid
+ *  x       - the tile's x
+ *  y       - the tile's y
+ */
+size_t grid_reveal(grid_t *grid, size_t x, size_t y)
+{
+    /* Arguments checking */
+    assert(grid);
+    assert(grid_at(grid, x, y));
+
+    tile_t *tile = grid_at(grid, x, y);
+
+    /* Do not reveal if flagged or already revealed */
+    if(tile_up(*tile) != UNREVEALED)
+        return 0;
+
+    /* Deferred grid, placing the mines now */
+    if(grid->pending)
+    {
+        /* The tile and its neighbours stay safe */
+        /* (only the tile if there is no room)   */
+        size_t skip[9], nskip = 0;
+
+        for(size_t sy = (y > 0 ? y - 1 : y); sy <= y + 1 && sy < grid->rows; ++sy)
+            for(size_t sx = (x > 0 ? x - 1 : x); sx <= x + 1 && sx < grid->cols; ++sx)
+                skip[nskip++] = sy * grid->cols + sx;
+
+        if(grid->mines > grid->rows * grid->cols - nskip)
+        {
+            skip[0] = y * grid->cols + x;
+            nskip = 1;
+        }
+
+        _grid_place(grid, skip, nskip);
+        complete_grid(grid);
+
+        grid->pending = false;
+    }
+
+    /* IF IT IS 1ST MOVE AND A MINE,
+     * CHANGE THE MINE'S POSITION */
+    /* (1st move - no safe tile revealed yet) */
+    if(tile_lo(*tile) == MINE && grid->safe_left == grid->rows * grid->cols - grid->mines)
+    {
+        /* Choosing random position for the mine */
+        size_t pos;
+
+        do
+            pos = (size_t) rng_below(&grid->rng, grid->rows * grid->cols);
+        while(tile_lo(grid->tiles[pos]) == MINE);
+
+        /* Updating only the tiles around, the */
+        /* openings are labeled after the swap */
+        grid_set_mine(grid, pos % grid->cols, pos / grid->cols);
+        grid_clear_mine(grid, x, y);
+    }
+
+    /* Reveal all the mines if a mine was chosen */
+    if(tile_lo(*tile) == MINE)
     {
-        if((g->tiles[x] = (tile_t *) malloc(sizeof(tile_t) * rows)) == NULL)
+        for(size_t i = 0; i < grid->rows * grid->cols; ++i)
         {
-            free(g->tiles);
-            free(g);
-            return NULL;
+            if(tile_lo(grid->tiles[i]) == MINE)
+            {
+                tile_set_up(&grid->tiles[i], REVEALED);
+                _grid_log(grid, i);
+            }
         }
 
-        for(size_t y = 0; y < rows; ++y)
-        {
-            /* Setting default value */
-            grid_at(g, x, y)->up = UNREVEALED;
-            grid_at(g, x, y)->lo = D0;
-        }
+        return (size_t) -1;
     }
 
-    /* Randomizing mines position */
-    srand(seed == 0 ? time(NULL) : seed);
-
-    /* Collection of positions not yet used for mines */
-    size_t vpos[rows * cols];
-    size_t mines_left = mines;
+    /* Reveal all empties around (flood fill) */
+    else if(tile_lo(*tile) != D0)
     {
-        for(size_t i = 0; i < rows * cols; ++i)
-            vpos[i] = i;
+        /* Do not flood fill */
+        tile_set_up(tile, REVEALED);
+        _grid_log(grid, y * grid->cols + x);
+        --grid->safe_left;
+        return 1;
     }
 
-    /* Selecting positions until all mines have been placed */
-    while(mines_left > 0)
-    {
-        /*                       size of the 'vpos'                 */
-        /*                       vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv */
-        size_t index = rand() % ((rows * cols) - (mines - mines_left));
-
-        /* Obtaining chosen tile position */
-        size_t pos = vpos[index];
-
-        /* Erasing this position from the 'vpos' */
-        for(size_t i = index; i < (rows * cols) - (mines - mines_left) - 1u; ++i)
-            vpos[i] = vpos[i + 1];
-
-        /* Translating chosen position into (row x column) format */
-//        printf("\n[%d/%d]: \t%d\t%d\t\t(%zu)", mines - mines_left, mines, pos % cols, pos / cols, pos);
-        tile_t *temp = grid_at(g, pos % cols, pos / cols);
-
-        if(! temp)
-            return NULL;
+    /* Whole opening from the list, */
+    /* labeled on the first need    */
+    if(! grid->regions_tried)
+        _grid_label(grid);
 
-        temp->lo = MINE;
+    if(grid->regions_valid)
+    {
+        size_t count = _grid_reveal_opening(grid, grid->region[y * grid->cols + x] - 1);
 
-        --mines_left;
+        if(count != (size_t) -1)
+            return count;
     }
 
-    complete_grid(g);
-    return g;
+    /* Flood fill */
+
+    return _grid_reveal_loop(grid, x, y);
 }
 
-/* Loads grid from file.
+/* Flags or unflags an unrevealed tile,
+ * the flag counts of its neighbours follow.
+ *
+ *  grid    - the grid
+ *  x, y    - the tile's position
  *
- *  file    - the file name
+ * Returns true if the tile is flagged now.
  */
-grid_t *grid_load(const char *filename)
+bool grid_flag(grid_t *grid, size_t x, size_t y)
 {
-    /* Pointer checking */
-    assert(filename);
-
-    grid_t *grid = NULL;
-    size_t rows = 0;
-    size_t cols = 0;
+    /* Arguments checking */
+    assert(grid);
+    assert(grid_at(grid, x, y));
 
-    size_t line_number = 0;
+    tile_t *tile = grid_at(grid, x, y);
+    int step;
 
-    FILE *file = fopen(filename, "r");
-    if(! file)
+    if(tile_up(*tile) == UNREVEALED)
     {
-        /* Oops */
-        return NULL;
+        tile_set_up(tile, FLAG);
+        step = 1;
     }
-
-    while(! feof(file))
+    else if(tile_up(*tile) == FLAG)
     {
-        /* First line: rows */
-        if(line_number == 0)
-        {
-            if(fscanf(file, "%zu", &rows) < 1 || rows > GRID_MAX_HEIGHT)
-                return NULL;
-        }
-
-        /* Second line: cols */
-        else if(line_number == 1)
-        {
-            if(fscanf(file, "%zu", &cols) < 1 || cols > GRID_MAX_WIDTH)
-                return NULL;
-            
-            /* Memory allocation */
-            if(!(grid = new_grid(rows, cols, 0, 0)))
-            {
-                /* Oops */
-                return NULL;
-            }
-        }
-
-        /* Next lines: mine points */
-        else
-        {
-            size_t x, y;
-            if(fscanf(file, "%zu %zu", &x, &y) < 2 || x >= cols || y >= rows)
-            {
-                /* Oops */
-                free(grid);
-                return NULL;
-            }
-
-            grid_at(grid, x, y)->lo = MINE;
-        }
-
-        ++line_number;
+        tile_set_up(tile, UNREVEALED);
+        step = -1;
     }
+    else
+        return false;
 
-    fclose(file);
+    _grid_log(grid, y * grid->cols + x);
 
-    /* Recalculating */
-    complete_grid(grid);
+    for(size_t sy = (y > 0 ? y - 1 : y); sy <= y + 1 && sy < grid->rows; ++sy)
+        for(size_t sx = (x > 0 ? x - 1 : x); sx <= x + 1 && sx < grid->cols; ++sx)
+            grid->flags_near[sy * grid->cols + sx] += step;
 
-    return grid;
+    return step > 0;
 }
 
-/* Completes lower layer of the grid
- * based on the mine placement.
+/* Reveals the unflagged neighbours of a revealed
+ * number, if as many flags as the number are
+ * around it (chord). Flags are counted as they
+ * are set, so the check is a single comparison.
  *
- *  grid     - the grid
+ *  grid    - the grid
+ *  x, y    - the tile's position
+ *
+ * Returns number of revealed tiles,
+ * (size_t) -1 if a mine was among them.
  */
-void complete_grid(grid_t *grid)
+size_t grid_chord(grid_t *grid, size_t x, size_t y)
 {
-    /* Pointer check */
+    /* Arguments checking */
     assert(grid);
+    assert(grid_at(grid, x, y));
 
-    /* Calculations for each tile */
-    /* L - Left, R - Right, U - Up, D - Down */
-    for(size_t x = 0; x < grid->cols; ++x)
-    {
-        for(size_t y = 0; y < grid->rows; ++y)
-        {
-            int tile_val = 0;
+    const tile_t tile = *grid_at(grid, x, y);
 
-            /* Skip if mine */
-            if(grid_at(grid, x, y)->lo == MINE)
-                continue;
+    /* The tile itself is never flagged here */
+    if(tile_up(tile) != REVEALED || tile_lo(tile) == D0 || tile_lo(tile) == MINE ||
+       grid->flags_near[y * grid->cols + x] != (uint8_t) tile_lo(tile))
+        return 0;
 
-            /* LU */
-            if(grid_at(grid, x - 1u, y - 1u) && grid_at(grid, x - 1u, y - 1u)->lo == MINE)
-                ++tile_val;
+    size_t count_revealed = 0;
 
-            /* U */
-            if(grid_at(grid, x, y - 1u) && grid_at(grid, x, y - 1u)->lo == MINE)
-                ++tile_val;
+    for(size_t sy = (y > 0 ? y - 1 : y); sy <= y + 1 && sy < grid->rows; ++sy)
+    {
+        for(size_t sx = (x > 0 ? x - 1 : x); sx <= x + 1 && sx < grid->cols; ++sx)
+        {
+            size_t revealed = grid_reveal(grid, sx, sy);
 
-            /* RU */
-            if(grid_at(grid, x + 1u, y - 1u) && grid_at(grid, x + 1u, y - 1u)->lo == MINE)
-                ++tile_val;
+            /* Wrong flag */
+            if(revealed == (size_t) -1)
+                return revealed;
 
-            /* R */
-            if(grid_at(grid, x + 1u, y) && grid_at(grid, x + 1u, y)->lo == MINE)
-                ++tile_val;
+            count_revealed += revealed;
+        }
+    }
 
-            /* RD */
-            if(grid_at(grid, x + 1u, y + 1u) && grid_at(grid, x + 1u, y + 1u)->lo == MINE)
-                ++tile_val;
+    return count_revealed;
+}
 
-            /* D */
-            if(grid_at(grid, x, y + 1u) && grid_at(grid, x, y + 1u)->lo == MINE)
-                ++tile_val;
+/* Places a mine on a tile. Only the
+ * tile and its neighbours are updated.
+ *
+ *  grid    - the grid
+ *  x, y    - the tile's position
+ *
+ * Returns false if there was a mine already.
+ */
+bool grid_set_mine(grid_t *grid, size_t x, size_t y)
+{
+    /* Arguments checking */
+    assert(grid);
+    assert(grid_at(grid, x, y));
 
-            /* LD */
-            if(grid_at(grid, x - 1u, y + 1u) && grid_at(grid, x - 1u, y + 1u)->lo == MINE)
-                ++tile_val;
+    tile_t *tile = grid_at(grid, x, y);
 
-            /* L */
-            if(grid_at(grid, x - 1u, y) && grid_at(grid, x - 1u, y)->lo == MINE)
-                ++tile_val;
+    if(tile_lo(*tile) == MINE)
+        return false;
 
-            /* Giving 0 - 8 value */
+    /* Neighbours' counts go up */
+    for(size_t sy = (y > 0 ? y - 1 : y); sy <= y + 1 && sy < grid->rows; ++sy)
+    {
+        tile_t *row = grid_row(grid, sy);
 
-            if(tile_val == 0)
-                grid_at(grid, x, y)->lo = D0;
-            else
-                grid_at(grid, x, y)->lo = (lo_layer_t) (tile_val + '0');
+        for(size_t sx = (x > 0 ? x - 1 : x); sx <= x + 1 && sx < grid->cols; ++sx)
+        {
+            if(tile_lo(row[sx]) != MINE)
+                tile_set_lo(&row[sx], tile_lo(row[sx]) + 1);
+
+            _grid_log(grid, sy * grid->cols + sx);
         }
     }
 
+    tile_set_lo(tile, MINE);
+
+    ++grid->mines;
+    _grid_unlabel(grid);
+
+    if(tile_up(*tile) != REVEALED)
+        --grid->safe_left;
 
+    return true;
 }
 
-/* Reveals the tiles starting with
- * the specified one
+/* Removes a mine from a tile. Only the
+ * tile and its neighbours are updated.
  *
  *  grid    - the grid
- *  x       - the tile's x
- *  y       - the tile's y
+ *  x, y    - the tile's position
+ *
+ * Returns false if there was no mine.
  */
-size_t grid_reveal(grid_t *grid, size_t x, size_t y)
+bool grid_clear_mine(grid_t *grid, size_t x, size_t y)
 {
     /* Arguments checking */
     assert(grid);
     assert(grid_at(grid, x, y));
 
-    /* Do not reveal if flagged or already revealed */
-    if(grid_at(grid, x, y)->up != UNREVEALED)
-        return 0;
+    tile_t *tile = grid_at(grid, x, y);
+    int tile_val = 0;
 
-    /* IF IT IS 1ST MOVE AND A MINE,
-     * CHANGE THE MINE'S POSITION */
-    if(grid_at(grid, x, y)->lo == MINE)
+    if(tile_lo(*tile) != MINE)
+        return false;
+
+    /* Neighbours' counts go down, the tile
+     * gets the count of the mines around */
+    for(size_t sy = (y > 0 ? y - 1 : y); sy <= y + 1 && sy < grid->rows; ++sy)
     {
-        for(size_t y = 0; y < grid->rows; ++y)
-            for(size_t x = 0; x < grid->cols; ++x)
-                if(grid_at(grid, x, y)->up == REVEALED)
-                    goto END;
+        tile_t *row = grid_row(grid, sy);
 
-        /* Yes, it is 1st move */
-        /* Choosing next position for the mine */
-        for(size_t i = 0; i < grid->rows * grid->cols; ++i)
+        for(size_t sx = (x > 0 ? x - 1 : x); sx <= x + 1 && sx < grid->cols; ++sx)
         {
-            tile_t *temp = grid_at(grid, i % grid->cols, i / grid->cols);
-            if(! temp || temp->lo == MINE)
-                continue;
+            if(tile_lo(row[sx]) == MINE)
+                ++tile_val;
+            else
+                tile_set_lo(&row[sx], tile_lo(row[sx]) - 1);
 
-            temp->lo = MINE;
-            break;
+            _grid_log(grid, sy * grid->cols + sx);
         }
+    }
 
-        grid_at(grid, x, y)->lo = D0;
+    /* The tile itself was counted */
+    tile_set_lo(tile, (lo_layer_t) (tile_val - 1));
 
-        /* Updating the grid */
-        complete_grid(grid);
+    --grid->mines;
+    _grid_unlabel(grid);
 
-        END:;
-    }
+    if(tile_up(*tile) != REVEALED)
+        ++grid->safe_left;
 
-    /* Reveal all the mines if a mine was chosen */
-    if(grid_at(grid, x, y)->lo == MINE)
+    return true;
+}
+
+/* Saves the grid's mines to a text file,
+ * in the format read by grid_load.
+ *
+ *  grid     - the grid
+ *  filename - the file name
+ *
+ * Returns 0 if succeeded.
+ */
+int grid_save_text(const grid_t *grid, const char *filename)
+{
+    /* Pointer checking */
+    assert(grid && filename);
+
+    FILE *file = fopen(filename, "w");
+    if(! file)
+        return EXIT_FAILURE;
+
+    /* Rows, cols, then 'x y' of each mine */
+    int status = fprintf(file, "%zu\n%zu\n", grid->rows, grid->cols) > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    for(size_t y = 0; y < grid->rows && status == EXIT_SUCCESS; ++y)
     {
-        for(size_t y = 0; y < grid->rows; ++y)
+        const tile_t *row = grid_row(grid, y);
+
+        for(size_t x = 0; x < grid->cols; ++x)
         {
-            for(size_t x = 0; x < grid->cols; ++x)
+            if(tile_lo(row[x]) == MINE && fprintf(file, "%zu %zu\n", x, y) < 0)
             {
-                if(grid_at(grid, x, y)->lo == MINE)
-                    grid_at(grid, x, y)->up = REVEALED;
+                status = EXIT_FAILURE;
+                break;
             }
         }
+    }
 
-        return (size_t) -1;
+    if(fclose(file) != 0)
+        status = EXIT_FAILURE;
+
+    return status;
+}
+
+/* Saves the grid's mines to a binary file,
+ * read back by grid_load. The header holds
+ * the size, mine count, seed and a checksum,
+ * then the mine map follows, a bit per tile
+ * (rows padded to whole bytes).
+ *
+ *  grid     - the grid
+ *  filename - the file name
+ *
+ * Returns 0 if succeeded.
+ */
+int grid_save(const grid_t *grid, const char *filename)
+{
+    /* Pointer checking */
+    assert(grid && filename);
+
+    const size_t stride = (grid->cols + 7) / 8;
+    const size_t size = GRID_BIN_HEADER + stride * grid->rows;
+
+    uint8_t *data = (uint8_t *) calloc(size, sizeof(uint8_t));
+    if(! data)
+        return EXIT_FAILURE;
+
+    uint8_t *map = data + GRID_BIN_HEADER;
+
+    for(size_t y = 0; y < grid->rows; ++y)
+    {
+        const tile_t *row = grid_row(grid, y);
+        uint8_t *bits = map + y * stride;
+
+        for(size_t x = 0; x < grid->cols; ++x)
+            if(tile_lo(row[x]) == MINE)
+                bits[x / 8] |= (uint8_t) (1 << (x % 8));
     }
 
-    /* Reveal all empties around (flood fill) */
-    else if(grid_at(grid, x, y)->lo != D0)
+    memcpy(data, GRID_BIN_MAGIC, 4);
+    data[4] = GRID_BIN_VERSION;
+    _grid_put64(data + 8, grid->rows);
+    _grid_put64(data + 16, grid->cols);
+    _grid_put64(data + 24, grid->mines);
+    _grid_put64(data + 32, grid->seed);
+    _grid_put64(data + 40, _grid_checksum(map, stride * grid->rows));
+
+    int status = EXIT_FAILURE;
+    FILE *file = fopen(filename, "wb");
+
+    if(file)
     {
-        /* Do not flood fill */
-        grid_at(grid, x, y)->up = REVEALED;
-        return 1;
+        if(fwrite(data, 1, size, file) == size)
+            status = EXIT_SUCCESS;
+
+        if(fclose(file) != 0)
+            status = EXIT_FAILURE;
     }
 
-    /* Flood fill */
+    free(data);
 
-    return _grid_reveal_loop(grid, x, y);
+    return status;
 }
 
 /* Gives a pointer to a tile at position.
@@ -325,7 +1448,106 @@ tile_t *grid_at(const grid_t *grid, size_t x, size_t y)
     if(x >= grid->cols || y >= grid->rows)
         return NULL;
 
-    return &(grid->tiles[x][y]);
+    return &(grid->tiles[y * grid->cols + x]);
+}
+
+/* Gives a pointer to the first tile of a row.
+ * Tiles of the row follow it contiguously.
+ *
+ *  grid    - the grid
+ *  y       - the row
+ *
+ * Returns NULL if failed, valid pointer otherwise.
+ */
+tile_t *grid_row(const grid_t *grid, size_t y)
+{
+    /* Pointer checking */
+    assert(grid);
+
+    /* Bounds checking */
+    if(y >= grid->rows)
+        return NULL;
+
+    return &(grid->tiles[y * grid->cols]);
+}
+
+/* Checks if every non-mine tile has been
+ * revealed. Constant time, the grid keeps
+ * the count of unrevealed safe tiles.
+ *
+ *  grid    - the grid
+ */
+bool grid_won(const grid_t *grid)
+{
+    /* Pointer checking */
+    assert(grid);
+
+    return grid->safe_left == 0;
+}
+
+/* Empties the log of changed tiles. Called
+ * by the grid's owner once every reader has
+ * caught up (readers keep their position as
+ * grid->log_base + the entries read).
+ *
+ *  grid    - the grid
+ */
+void grid_log_clear(grid_t *grid)
+{
+    /* Pointer checking */
+    assert(grid);
+
+    grid->log_base += grid->log_len;
+    grid->log_len = 0;
+}
+
+/* Empties the log and leaves a gap in it,
+ * so every reader looks at the whole grid.
+ * Used after changing the tiles directly.
+ *
+ *  grid    - the grid
+ */
+void grid_log_reset(grid_t *grid)
+{
+    /* Pointer checking */
+    assert(grid);
+
+    grid->log_base += grid->log_len + 1;
+    grid->log_len = 0;
+}
+
+/* Gives the number of openings (groups of
+ * connected empty tiles), labels them first
+ * if needed.
+ *
+ *  grid    - the grid
+ *
+ * Returns 0 if the openings are not known
+ * (no memory, or the grid is too big).
+ */
+size_t grid_openings(grid_t *grid)
+{
+    /* Pointer checking */
+    assert(grid);
+
+    if(! grid->regions_tried)
+        _grid_label(grid);
+
+    return grid->regions_valid ? grid->openings : 0;
+}
+
+/* Gives the number of tiles an opening
+ * reveals, its numbered border included.
+ *
+ *  grid    - the grid
+ *  i       - the opening, below grid_openings()
+ */
+size_t grid_opening_size(const grid_t *grid, size_t i)
+{
+    /* Arguments checking */
+    assert(grid && grid->regions_valid && i < grid->openings);
+
+    return grid->open_start[i + 1] - grid->open_start[i];
 }
 
 /* Deletes the grid, frees up the memory.
@@ -338,53 +1560,179 @@ void del_grid(grid_t *grid)
     if(grid == NULL)
         return;
 
-    for(size_t x = 0u; x < grid->cols; ++x)
-        free(grid->tiles[x]);
-
     free(grid->tiles);
+    free(grid->work);
+    free(grid->flags_near);
+    free(grid->log);
+    free(grid->region);
+    free(grid->open_start);
+    free(grid->open_tiles);
     free(grid);
 }
 
 
 /* Used for grid_reveal.
  * Should not be called explicitly.
+ * Scanline flood fill over the empty tiles,
+ * reveals their numbered border (diagonals too).
  */
 size_t _grid_reveal_loop(grid_t *grid, size_t x, size_t y)
 {
     assert(grid);
 
     size_t count_revealed = 0;
+    tile_t *tile = grid_at(grid, x, y);
 
     /* Invalid tile */
-    if(! grid_at(grid, x, y))
+    if(! tile)
         return 0;
 
     /* If this tile has been revealed already, stop. */
     /* If this tile has been flagged, stop. */
-    if(grid_at(grid, x, y)->up != UNREVEALED)
+    if(tile_up(*tile) != UNREVEALED)
         return count_revealed;
 
-    /* Reveal this tile */
-    grid_at(grid, x, y)->up = REVEALED;
-    ++count_revealed;
+    /* If this tile is not empty, reveal it and stop. */
+    if(tile_lo(*tile) != D0)
+    {
+        tile_set_up(tile, REVEALED);
+        _grid_log(grid, y * grid->cols + x);
+        --grid->safe_left;
+        return 1;
+    }
+
+    /* Stack of empty tiles starting a span */
+    size_t top = 0;
+    grid->work[top++] = y * grid->cols + x;
 
-    /* If this tile is not empty, stop. */
-    if(grid_at(grid, x, y)->lo != D0)
-        return count_revealed;
+    while(top > 0)
+    {
+        size_t pos = grid->work[--top];
+        size_t sy = pos / grid->cols;
+        tile_t *row = grid_row(grid, sy);
+
+        /* Pushed twice, done already */
+        if(tile_up(row[pos % grid->cols]) != UNREVEALED)
+            continue;
+
+        /* Span of unrevealed empty tiles */
+        /* (such a tile is a zero byte)    */
+        size_t xl = pos % grid->cols;
+        size_t xr = xl;
+
+        while(xl > 0 && row[xl - 1] == (tile_t) D0)
+            --xl;
+
+        while(xr + 1 < grid->cols && row[xr + 1] == (tile_t) D0)
+            ++xr;
 
-    /* Reveal other tiles around */
+        /* Span with its left and right neighbours */
+        size_t bl = (xl > 0) ? xl - 1 : xl;
+        size_t br = (xr + 1 < grid->cols) ? xr + 1 : xr;
 
-    if(x > 0)
-        count_revealed += _grid_reveal_loop(grid, x - 1, y);
+        for(size_t i = bl; i <= br; ++i)
+        {
+            if(tile_up(row[i]) != UNREVEALED)
+                continue;
+
+            tile_set_up(&row[i], REVEALED);
+            _grid_log(grid, sy * grid->cols + i);
+            ++count_revealed;
+        }
 
-    if(x < grid->cols - 1)
-        count_revealed += _grid_reveal_loop(grid, x + 1, y);
+        /* Rows above and below */
+        for(int d = -1; d <= 1; d += 2)
+        {
+            if((d < 0 && sy == 0) || (d > 0 && sy + 1 >= grid->rows))
+                continue;
 
-    if(y > 0)
-        count_revealed += _grid_reveal_loop(grid, x, y - 1);
+            tile_t *next = grid_row(grid, sy + d);
+            bool in_span = false;
+
+            for(size_t i = bl; i <= br; ++i)
+            {
+                /* Revealed or flagged */
+                if(tile_up(next[i]) != UNREVEALED)
+                {
+                    in_span = false;
+                    continue;
+                }
+
+                /* Numbered border */
+                if(tile_lo(next[i]) != D0)
+                {
+                    tile_set_up(&next[i], REVEALED);
+                    _grid_log(grid, (sy + d) * grid->cols + i);
+                    ++count_revealed;
+
+                    in_span = false;
+                    continue;
+                }
+
+                /* One push per span */
+                if(in_span)
+                    continue;
+
+                in_span = true;
+
+                if(top == grid->work_cap)
+                {
+                    size_t *temp = (size_t *) realloc(grid->work, sizeof(size_t) * grid->work_cap * 2);
+                    /* Out of memory, the rest stays unrevealed */
+                    if(! temp)
+                        break;
+
+                    grid->work = temp;
+                    grid->work_cap *= 2;
+                }
+
+                grid->work[top++] = (sy + d) * grid->cols + i;
+            }
+        }
+    }
 
-    if(y < grid->rows - 1)
-        count_revealed += _grid_reveal_loop(grid, x, y + 1);
+    /* Only safe tiles are ever revealed here */
+    grid->safe_left -= count_revealed;
 
     return count_revealed;
 }
+
+/* Used for checking complete_grid.
+ * Should not be called explicitly.
+ * Completes the grid with the given box sum
+ * (GRID_KERNEL_*) as the widest one, the
+ * narrower ones do the rest of each row.
+ * Returns 1 if the build or the CPU lacks it.
+ */
+int _grid_complete_with(grid_t *grid, int kernel)
+{
+    /* Pointer checking */
+    assert(grid);
+
+    _grid_kernel_t chosen = NULL;
+
+    switch(kernel)
+    {
+    case GRID_KERNEL_SCALAR:
+        chosen = _grid_box_scalar;
+        break;
+
+#ifdef GRID_SIMD_X86
+    case GRID_KERNEL_SSE2:
+        if(__builtin_cpu_supports("sse2"))
+            chosen = _grid_box_sse2;
+        break;
+
+    case GRID_KERNEL_AVX2:
+        if(__builtin_cpu_supports("avx2"))
+            chosen = _grid_box_avx2;
+        break;
+#endif
+    }
+
+    if(! chosen)
+        return EXIT_FAILURE;
+
+    _grid_complete(grid, chosen);
+    return EXIT_SUCCESS;
+}
@@ -11,16 +11,42 @@
 #ifndef _SAPER_GRID_H_FILE_
 #define _SAPER_GRID_H_FILE_
 
-#ifndef NDEBUG
-    #define GRID_MAX_WIDTH          500
-    #define GRID_MAX_HEIGHT         500
-#else
-    #define GRID_MAX_WIDTH          30
-    #define GRID_MAX_HEIGHT         20 
+/* Largest grid of the game, bigger than
+ * the terminal is shown in parts (with
+ * the solver, up to ~36 bytes per tile) */
+#define GRID_MAX_WIDTH              2000
+#define GRID_MAX_HEIGHT             2000
+
+/* Binary board file: header of GRID_BIN_HEADER
+ * bytes (magic, version byte, then rows, cols,
+ * mines, seed and the map's FNV-1a checksum as
+ * little-endian 64-bit values from offset 8),
+ * followed by the mine map */
+#define GRID_BIN_MAGIC              "SAPB"
+#define GRID_BIN_VERSION            1
+#define GRID_BIN_HEADER             48
+
+/* Text boards are read in blocks of that size */
+#define GRID_LOAD_BLOCK             (1 << 16)
+
+/* Binary boards are mapped, not read */
+#ifdef __linux__
+    #define GRID_MMAP
 #endif
 
+/* Vectorized complete_grid (x86 + GCC),
+ * -DGRID_NO_SIMD forces the scalar one */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && ! defined(GRID_NO_SIMD)
+    #define GRID_SIMD_X86
+#endif
+
+/* Box sums of complete_grid, narrowest first */
+#define GRID_KERNEL_SCALAR          0
+#define GRID_KERNEL_SSE2            1
+#define GRID_KERNEL_AVX2            2
+
 
-#include "terminal.h"
+#include "rng.h"
 #include "tile.h"
 
 #include <assert.h>
@@ -31,13 +57,53 @@
 #include <string.h>
 #include <time.h>
 
+#ifdef GRID_MMAP
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#ifdef GRID_SIMD_X86
+    #include <immintrin.h>
+#endif
 
-/* A grid */
+
+/* A grid.
+ * Tiles are stored row by row in one block.
+ * Every change of a tile is logged by its
+ * position, for readers following the game.
+ */
 typedef struct _sap_grid_t
 {
-    tile_t **tiles;                         /* Actual grid.             */
+    tile_t *tiles;                          /* Actual grid (row-major)  */
     size_t rows;                            /* No. of the grid's rows   */
     size_t cols;                            /* No. of the grid's columns*/
+    size_t mines;                           /* No. of mines             */
+    size_t safe_left;                       /* Unrevealed non-mine tiles*/
+    bool pending;                           /* Mines not placed yet     */
+
+    uint64_t seed;                          /* Seed of the mine layout  */
+    rng_t rng;                              /* Own generator            */
+
+    uint8_t *flags_near;                    /* Flags around each tile   */
+
+    size_t *log;                            /* Changed tiles, in order  */
+    size_t log_len;                         /* No. of logged changes    */
+    size_t log_cap;                         /* Capacity of the log      */
+    size_t log_base;                        /* Changes dropped so far   */
+
+    size_t *work;                           /* Flood fill stack         */
+    size_t work_cap;                        /* Capacity of the stack    */
+
+    uint32_t *region;                       /* Opening of an empty tile */
+    size_t *open_start;                     /* Openings' starts in list */
+    uint32_t *open_tiles;                   /* Tiles of the openings    */
+    size_t openings;                        /* No. of openings          */
+    size_t start_cap;                       /* Capacity of open_start   */
+    size_t tiles_cap;                       /* Capacity of open_tiles   */
+    bool regions_valid;                     /* Openings match the mines */
+    bool regions_tried;                     /* Labeled since mines set  */
 
 } grid_t;
 
@@ -47,20 +113,55 @@ typedef struct _sap_grid_t
  *  rows    - number of rows
  *  cols    - number of columns
  *  mines   - number of mines
- *  seed    - optional seed, if 0 the time() function will be used 
+ *  seed    - optional seed, if 0 a time based one is used (kept in grid->seed)
  * 
  *  Returns NULL if failed, valid pointer otherwise.
  */
-grid_t      *new_grid(size_t rows, size_t cols, size_t mines, unsigned int seed);
+grid_t      *new_grid(size_t rows, size_t cols, size_t mines, uint64_t seed);
 
-/* Loads grid from file.
+/* Creates new grid with given settings,
+ * the mines are placed at the first reveal,
+ * away from the revealed tile and its
+ * neighbours (so it always opens an area).
+ *
+ *  rows    - number of rows
+ *  cols    - number of columns
+ *  mines   - number of mines
+ *  seed    - optional seed, if 0 a time based one is used (kept in grid->seed)
+ *
+ *  Returns NULL if failed, valid pointer otherwise.
+ */
+grid_t      *new_grid_deferred(size_t rows, size_t cols, size_t mines, uint64_t seed);
+
+/* Makes the grid a new deferred one of the
+ * same size and mine count, keeping its
+ * memory. Readers of the log start over.
+ *
+ *  grid    - the grid
+ *  seed    - optional seed, if 0 a time based one is used (kept in grid->seed)
+ */
+void        grid_reset(grid_t *grid, uint64_t seed);
+
+/* Loads grid from file, either a binary
+ * board (see grid_save) or a text one:
+ * rows, cols, then 'x y' of each mine.
+ * Any white space separates the numbers,
+ * a mine listed twice counts once.
  *
  *  filename - the file name
+ *  line     - gets the line of the first bad entry
+ *             of a text board, 0 if the file was
+ *             not read at all (can be NULL)
  */
-grid_t      *grid_load(const char *filename);
+grid_t      *grid_load(const char *filename, size_t *line);
 
 /* Completes lower layer of the grid
  * based on the mine placement.
+ * Counts are a 3x3 box sum over a padded
+ * mine mask, done a row at a time
+ * (SSE2/AVX2 if the CPU supports it).
+ * Drops the openings' labels, grid_reveal
+ * makes them again when needed.
  *
  *  grid     - the grid
  */
@@ -77,6 +178,72 @@ void        complete_grid(grid_t *grid);
  */
 size_t      grid_reveal(grid_t *grid, size_t x, size_t y);
 
+/* Flags or unflags an unrevealed tile,
+ * the flag counts of its neighbours follow.
+ *
+ *  grid    - the grid
+ *  x, y    - the tile's position
+ *
+ * Returns true if the tile is flagged now.
+ */
+bool        grid_flag(grid_t *grid, size_t x, size_t y);
+
+/* Reveals the unflagged neighbours of a revealed
+ * number, if as many flags as the number are
+ * around it (chord). Flags are counted as they
+ * are set, so the check is a single comparison.
+ *
+ *  grid    - the grid
+ *  x, y    - the tile's position
+ *
+ * Returns number of revealed tiles,
+ * (size_t) -1 if a mine was among them.
+ */
+size_t      grid_chord(grid_t *grid, size_t x, size_t y);
+
+/* Places a mine on a tile. Only the
+ * tile and its neighbours are updated.
+ *
+ *  grid    - the grid
+ *  x, y    - the tile's position
+ *
+ * Returns false if there was a mine already.
+ */
+bool        grid_set_mine(grid_t *grid, size_t x, size_t y);
+
+/* Removes a mine from a tile. Only the
+ * tile and its neighbours are updated.
+ *
+ *  grid    - the grid
+ *  x, y    - the tile's position
+ *
+ * Returns false if there was no mine.
+ */
+bool        grid_clear_mine(grid_t *grid, size_t x, size_t y);
+
+/* Saves the grid's mines to a text file,
+ * in the format read by grid_load.
+ *
+ *  grid     - the grid
+ *  filename - the file name
+ *
+ * Returns 0 if succeeded.
+ */
+int         grid_save_text(const grid_t *grid, const char *filename);
+
+/* Saves the grid's mines to a binary file,
+ * read back by grid_load. The header holds
+ * the size, mine count, seed and a checksum,
+ * then the mine map follows, a bit per tile
+ * (rows padded to whole bytes).
+ *
+ *  grid     - the grid
+ *  filename - the file name
+ *
+ * Returns 0 if succeeded.
+ */
+int         grid_save(const grid_t *grid, const char *filename);
+
 /* Gives a pointer to a tile at position. 
  *
  *  grid    - the grid
@@ -87,6 +254,60 @@ size_t      grid_reveal(grid_t *grid, size_t x, size_t y);
  */
 tile_t      *grid_at(const grid_t *grid, size_t x, size_t y);
 
+/* Gives a pointer to the first tile of a row.
+ * Tiles of the row follow it contiguously.
+ *
+ *  grid    - the grid
+ *  y       - the row
+ *
+ * Returns NULL if failed, valid pointer otherwise.
+ */
+tile_t      *grid_row(const grid_t *grid, size_t y);
+
+/* Checks if every non-mine tile has been
+ * revealed. Constant time, the grid keeps
+ * the count of unrevealed safe tiles.
+ *
+ *  grid    - the grid
+ */
+bool        grid_won(const grid_t *grid);
+
+/* Empties the log of changed tiles. Called
+ * by the grid's owner once every reader has
+ * caught up (readers keep their position as
+ * grid->log_base + the entries read).
+ *
+ *  grid    - the grid
+ */
+void        grid_log_clear(grid_t *grid);
+
+/* Empties the log and leaves a gap in it,
+ * so every reader looks at the whole grid.
+ * Used after changing the tiles directly.
+ *
+ *  grid    - the grid
+ */
+void        grid_log_reset(grid_t *grid);
+
+/* Gives the number of openings (groups of
+ * connected empty tiles), labels them first
+ * if needed.
+ *
+ *  grid    - the grid
+ *
+ * Returns 0 if the openings are not known
+ * (no memory, or the grid is too big).
+ */
+size_t      grid_openings(grid_t *grid);
+
+/* Gives the number of tiles an opening
+ * reveals, its numbered border included.
+ *
+ *  grid    - the grid
+ *  i       - the opening, below grid_openings()
+ */
+size_t      grid_opening_size(const grid_t *grid, size_t i);
+
 /* Deletes the grid, frees up the memory.
  *
  *  grid    - object to be deleted
@@ -96,9 +317,20 @@ void        del_grid(grid_t *grid);
 
 /* Used for grid_reveal. 
  * Should not be called explicitly.
+ * Scanline flood fill over the empty tiles,
+ * reveals their numbered border (diagonals too).
  * Returns no of revealed tiles.
  */
 size_t      _grid_reveal_loop(grid_t *grid, size_t x, size_t y);
 
+/* Used for checking complete_grid.
+ * Should not be called explicitly.
+ * Completes the grid with the given box sum
+ * (GRID_KERNEL_*) as the widest one, the
+ * narrower ones do the rest of each row.
+ * Returns 1 if the build or the CPU lacks it.
+ */
+int         _grid_complete_with(grid_t *grid, int kernel);
+
 
 #endif /*_SAPER_GRID_H_FILE_ */
\ No newline at end of file
@@ -23,10 +23,11 @@ static int _qsort_comp(const void *e1, const void *e2)
  *
  *  name        - player's name
  *  score       - the score
+ *  rate        - 3BV/s of the game
  * 
  *  Returns 0 if succeeded.
  */
-int lead_add(const char *name, size_t score)
+int lead_add(const char *name, size_t score, double rate)
 {
     /* Pointer check */
     assert(name);
@@ -39,7 +40,7 @@ int lead_add(const char *name, size_t score)
         return EXIT_FAILURE;
 
     /* Adding new player to the end */
-    if(fprintf(file, "%s %zu\n", name, score) < 2)
+    if(fprintf(file, "%s %zu %.2f\n", name, score, rate) < 2)
     {
         /* Failed */
         fclose(file);
@@ -134,6 +135,10 @@ player_t    *lead_get(size_t n)
         /* Trying to parse the score */
         list[i].score = (size_t) atoi(score);
 
+        /* 3BV/s, missing in older files */
+        char *rate = strchr(score, ' ');
+        list[i].rate = rate ? atof(rate) : 0;
+
         ++i;
     }
 
@@ -147,6 +152,7 @@ player_t    *lead_get(size_t n)
     {
         list[i].name = NULL;
         list[i].score = 0;
+        list[i].rate = 0;
         ++i;
     }
 
@@ -25,6 +25,7 @@ typedef struct _sap_player
 {
     char *name;
     size_t score;
+    double rate;        /* 3BV/s of the won game, 0 if lost */
 
 } player_t;
 
@@ -33,10 +34,11 @@ typedef struct _sap_player
  *
  *  name        - player's name
  *  score       - the score
+ *  rate        - 3BV/s of the game
  * 
  *  Returns 0 if succeeded.
  */
-int         lead_add(const char *name, size_t score);
+int         lead_add(const char *name, size_t score, double rate);
 
 /* Returns the list of top n players.
  * If the list is too short, missing
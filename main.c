@@ -16,9 +16,19 @@ void help(void)
     printf(" Flagi:\n\n");
     printf(" h           - wyswietla pomoc\n"
            " c           - wylacza obsluge kolorow\n"
+           " m           - kompaktowa plansza (2 znaki na pole)\n"
+           " b           - pierwszy ruch zawsze odslania obszar\n"
+           " e           - edytor planszy (m<kolumna><wiersz>, z - zapis)\n"
+           " g           - plansza bez zgadywania (wlacza tez b)\n"
            " f <plik>    - korzysta z planszy z pliku\n"
+           " k <plik>    - zapisuje plansze z -f w formacie binarnym\n"
            " r <plik>    - korzysta z pliku ruchow\n"
            " z <wartosc> - ustawia ziarno generatora\n\n");
+    printf(" Widok (plansza wieksza niz terminal):\n\n"
+           " w<kolumna><wiersz>  - pole na srodku\n"
+           " wg / wd / wl / wp   - przesuwa w gore, w dol, w lewo, w prawo\n"
+           " o                   - podglad calej planszy (i powrot)\n"
+           " strzalki            - przesuwaja widok (przy pustym wejsciu)\n\n");
 
     exit(EXIT_SUCCESS);
 }
@@ -30,12 +40,13 @@ void analyse_cmd(int argc, char **argv)
 
     /* Game settings */
     int settings = DRAW_ROW_INDEXING | DRAW_COL_INDEXING;
-    int seed = 0;
+    uint64_t seed = 0;
     char map_name[128];     map_name[0] = '\0';
     char move_name[128];    move_name[0] = '\0';
+    char bin_name[128];     bin_name[0] = '\0';
 
 #if 1
-    while((opt = getopt(argc, argv, "hcf:r:z:")) != EOF)
+    while((opt = getopt(argc, argv, "hcmbegf:k:r:z:")) != EOF)
     {
         switch(opt)
         {
@@ -47,8 +58,31 @@ void analyse_cmd(int argc, char **argv)
                 settings |= DRAW_MONO;
                 break;
 
+            case 'm':
+                settings |= DRAW_COMPACT;
+                break;
+
+            case 'b':
+                settings |= GAME_SAFE_OPENING;
+                break;
+
+            case 'e':
+                settings |= GAME_EDITOR;
+                break;
+
+            case 'g':
+                settings |= GAME_NO_GUESS | GAME_SAFE_OPENING;
+                break;
+
             case 'f':
             {
+                /* Does the file name fit? */
+                if(strlen(optarg) >= sizeof(map_name))
+                {
+                    fprintf(stderr, "-f: Za dluga nazwa pliku.");
+                    exit(EXIT_FAILURE);
+                }
+
                 /* Is the file name valid? */
                 if(! strcpy(map_name, optarg) || strlen(map_name) < 1)
                 {
@@ -58,8 +92,33 @@ void analyse_cmd(int argc, char **argv)
                 break;
             }
 
+            case 'k':
+            {
+                /* Does the file name fit? */
+                if(strlen(optarg) >= sizeof(bin_name))
+                {
+                    fprintf(stderr, "-k: Za dluga nazwa pliku.");
+                    exit(EXIT_FAILURE);
+                }
+
+                /* Is the file name valid? */
+                if(! strcpy(bin_name, optarg) || strlen(bin_name) < 1)
+                {
+                    fprintf(stderr, "-k: Brak nazwy pliku.");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+
             case 'r':
             {
+                /* Does the file name fit? */
+                if(strlen(optarg) >= sizeof(move_name))
+                {
+                    fprintf(stderr, "-r: Za dluga nazwa pliku.");
+                    exit(EXIT_FAILURE);
+                }
+
                 /* Is the file name valid? */
                 if(! strcpy(move_name, optarg) || strlen(move_name) < 1)
                 {
@@ -70,7 +129,7 @@ void analyse_cmd(int argc, char **argv)
             }
 
             case 'z':
-                seed = atoi(optarg);
+                seed = strtoull(optarg, NULL, 0);
                 break;
 
             case '?':
@@ -83,11 +142,27 @@ void analyse_cmd(int argc, char **argv)
     }
 #endif
 
+    /* Converting the board only */
+    if(strlen(bin_name))
+    {
+        grid_t *grid = (strlen(map_name)) ? grid_load(map_name, NULL) : NULL;
+
+        if(! grid || grid_save(grid, bin_name))
+        {
+            fprintf(stderr, "-k: Nie mozna przekonwertowac planszy.");
+            del_grid(grid);
+            exit(EXIT_FAILURE);
+        }
+
+        del_grid(grid);
+        exit(EXIT_SUCCESS);
+    }
+
     /* STARTING THE GAME */
     game_init(settings, 
     (strlen(map_name)) ? map_name : NULL,
     (strlen(move_name)) ? move_name : NULL,
-    (unsigned int) seed);
+    seed);
 
 }
 
@@ -0,0 +1,905 @@
+/*
+ *  odds.c
+ *
+ *  Extends 'odds.h'.
+ *
+ */
+
+#include "odds.h"
+
+
+#define _ODDS_CHECK_EVERY           4096    /* Steps between clock reads*/
+#define _ODDS_NONE                  UINT32_MAX
+
+
+/* A revealed number: its unknown tiles
+ * and the mines among them.
+ */
+typedef struct _sap_odds_rule_t
+{
+    uint32_t vars[8];
+    uint8_t len;
+    int need;
+
+} _odds_rule_t;
+
+/* Mine layouts of a component of n tiles,
+ * for low..low+span-1 mines in it.
+ */
+typedef struct _sap_odds_part_t
+{
+    size_t n;
+    size_t low;
+    size_t span;
+    double *count;                          /* Layouts with low+s mines */
+    double *tally;                          /* Of them with tile v mined*/
+                                            /* at [s * n + v]           */
+} _odds_part_t;
+
+/* A counted component, kept by its constraints. */
+typedef struct _sap_odds_entry_t
+{
+    uint64_t hash;
+    size_t *key;
+    size_t key_len;
+    _odds_part_t part;
+
+} _odds_entry_t;
+
+/* Working state of a computation. */
+typedef struct _sap_odds_work_t
+{
+    uint32_t *var_of;                       /* Frontier index of a tile */
+    size_t *vars;                           /* Tiles of the frontier    */
+    size_t vars_len, vars_cap;
+
+    _odds_rule_t *rules;                    /* Numbers next to it       */
+    size_t rules_len, rules_cap;
+
+    uint32_t *comp_of;                      /* Component of a tile      */
+    size_t *comp_vars;                      /* Tiles, by component      */
+    size_t *comp_rules;                     /* Numbers, by component    */
+    size_t *var_start;                      /* Where components begin   */
+    size_t *rule_start;
+    size_t comps;
+
+    _odds_part_t *parts;                    /* Layouts of components    */
+
+    size_t unknown;                         /* Unrevealed tiles         */
+    size_t mines_left;                      /* Mines not revealed       */
+
+} _odds_work_t;
+
+
+/* Current time in seconds. */
+static double _odds_now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Makes room for one more item in a list. */
+static int _odds_grow(void **list, size_t *cap, size_t len, size_t item)
+{
+    if(len < *cap)
+        return EXIT_SUCCESS;
+
+    const size_t next = *cap ? 2 * *cap : 64;
+    void *temp = realloc(*list, item * next);
+    if(! temp)
+        return EXIT_FAILURE;
+
+    *list = temp;
+    *cap = next;
+
+    return EXIT_SUCCESS;
+}
+
+/* Root of a tile's group (union-find). */
+static uint32_t _odds_find(uint32_t *parent, uint32_t v)
+{
+    while(parent[v] != v)
+    {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+
+    return v;
+}
+
+/* Allocates the layouts of a component. */
+static int _odds_part_alloc(_odds_part_t *part, size_t n, size_t low, size_t span)
+{
+    part->n = n;
+    part->low = low;
+    part->span = span;
+    part->count = (double *) calloc(span, sizeof(double));
+    part->tally = (double *) calloc(span * n, sizeof(double));
+
+    return (part->count && part->tally) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Frees the layouts of a component. */
+static void _odds_part_free(_odds_part_t *part)
+{
+    free(part->count);
+    free(part->tally);
+
+    part->count = part->tally = NULL;
+}
+
+/* Copies the layouts of a component. */
+static int _odds_part_copy(_odds_part_t *dest, const _odds_part_t *src)
+{
+    if(_odds_part_alloc(dest, src->n, src->low, src->span) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+    memcpy(dest->count, src->count, sizeof(double) * src->span);
+    memcpy(dest->tally, src->tally, sizeof(double) * src->span * src->n);
+
+    return EXIT_SUCCESS;
+}
+
+/* FNV-1a of a component's key. */
+static uint64_t _odds_hash(const size_t *key, size_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for(size_t i = 0; i < len; ++i)
+    {
+        hash ^= (uint64_t) key[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/* Counts the mine layouts of a component by
+ * backtracking, tile after tile; a tile's
+ * value must leave each of its numbers able
+ * to get its mines. The rules refer to the
+ * tiles as 0..n-1.
+ *
+ * Returns false if out of time (or memory).
+ */
+static bool _odds_count(const _odds_rule_t *rules, size_t rules_len, _odds_part_t *part, double deadline)
+{
+    const size_t n = part->n;
+
+    /* Numbers around each tile, 8 at most */
+    uint32_t (*of)[8] = malloc(sizeof(*of) * n);
+    uint8_t *of_len = (uint8_t *) calloc(n, sizeof(uint8_t));
+    int8_t *val = (int8_t *) malloc(sizeof(int8_t) * n);
+    int *mines = (int *) calloc(rules_len, sizeof(int));
+    int *left = (int *) malloc(sizeof(int) * rules_len);
+
+    bool done = (of && of_len && val && mines && left);
+
+    for(size_t r = 0; done && r < rules_len; ++r)
+    {
+        left[r] = rules[r].len;
+
+        for(uint8_t j = 0; j < rules[r].len; ++j)
+        {
+            const uint32_t v = rules[r].vars[j];
+            of[v][of_len[v]++] = (uint32_t) r;
+        }
+    }
+
+    size_t steps = 0;
+    size_t k = 0;
+    ptrdiff_t i = 0;
+
+    if(done)
+        val[0] = -1;
+
+    while(done && i >= 0)
+    {
+        /* A layout */
+        if((size_t) i == n)
+        {
+            part->count[k] += 1;
+
+            for(size_t v = 0; v < n; ++v)
+                if(val[v] == 1)
+                    part->tally[k * n + v] += 1;
+
+            --i;
+            continue;
+        }
+
+        if(++steps % _ODDS_CHECK_EVERY == 0 && _odds_now() > deadline)
+        {
+            done = false;
+            break;
+        }
+
+        /* Taking back the last value */
+        if(val[i] >= 0)
+        {
+            for(uint8_t j = 0; j < of_len[i]; ++j)
+            {
+                mines[of[i][j]] -= val[i];
+                ++left[of[i][j]];
+            }
+
+            k -= (size_t) val[i];
+        }
+
+        /* Next value that fits */
+        int next = val[i] + 1;
+
+        for(; next <= 1; ++next)
+        {
+            bool fits = true;
+
+            for(uint8_t j = 0; j < of_len[i] && fits; ++j)
+            {
+                const uint32_t r = of[i][j];
+                fits = (mines[r] + next <= rules[r].need && mines[r] + next + left[r] - 1 >= rules[r].need);
+            }
+
+            if(fits)
+                break;
+        }
+
+        if(next > 1)
+        {
+            val[i--] = -1;
+            continue;
+        }
+
+        val[i] = (int8_t) next;
+        k += (size_t) next;
+
+        for(uint8_t j = 0; j < of_len[i]; ++j)
+        {
+            mines[of[i][j]] += next;
+            --left[of[i][j]];
+        }
+
+        if((size_t) ++i < n)
+            val[i] = -1;
+    }
+
+    free(of);
+    free(of_len);
+    free(val);
+    free(mines);
+    free(left);
+
+    return done;
+}
+
+/* Estimates a component that was not counted:
+ * a tile gets the mean share of mines of its
+ * numbers, as a single layout.
+ */
+static int _odds_estimate(const _odds_rule_t *rules, size_t rules_len, _odds_part_t *part)
+{
+    const size_t n = part->n;
+    double *share = (double *) calloc(n, sizeof(double));
+    size_t *seen = (size_t *) calloc(n, sizeof(size_t));
+
+    if(! share || ! seen)
+    {
+        free(share);
+        free(seen);
+        return EXIT_FAILURE;
+    }
+
+    for(size_t r = 0; r < rules_len; ++r)
+    {
+        for(uint8_t j = 0; j < rules[r].len; ++j)
+        {
+            share[rules[r].vars[j]] += (double) rules[r].need / rules[r].len;
+            ++seen[rules[r].vars[j]];
+        }
+    }
+
+    double sum = 0;
+
+    for(size_t v = 0; v < n; ++v)
+        sum += (share[v] /= (double) seen[v]);
+
+    int status = _odds_part_alloc(part, n, (size_t) (sum + 0.5), 1);
+
+    if(status == EXIT_SUCCESS)
+    {
+        part->count[0] = 1;
+        memcpy(part->tally, share, sizeof(double) * n);
+    }
+
+    free(share);
+    free(seen);
+
+    return status;
+}
+
+/* Frees the working state. */
+static void _odds_work_free(_odds_work_t *work)
+{
+    for(size_t c = 0; work->parts && c < work->comps; ++c)
+        _odds_part_free(&work->parts[c]);
+
+    free(work->var_of);
+    free(work->vars);
+    free(work->rules);
+    free(work->comp_of);
+    free(work->comp_vars);
+    free(work->comp_rules);
+    free(work->var_start);
+    free(work->rule_start);
+    free(work->parts);
+}
+
+/* Reads the numbers next to unknown tiles.
+ * Returns 1 if failed or if a number can
+ * not be satisfied.
+ */
+static int _odds_rules(const grid_t *grid, _odds_work_t *work)
+{
+    const size_t size = grid->rows * grid->cols;
+
+    if(! (work->var_of = (uint32_t *) malloc(sizeof(uint32_t) * size)))
+        return EXIT_FAILURE;
+
+    memset(work->var_of, 0xFF, sizeof(uint32_t) * size);
+
+    for(size_t y = 0; y < grid->rows; ++y)
+    {
+        for(size_t x = 0; x < grid->cols; ++x)
+        {
+            const tile_t tile = grid->tiles[y * grid->cols + x];
+
+            if(tile_up(tile) != REVEALED || tile_lo(tile) == MINE)
+                continue;
+
+            if(_odds_grow((void **) &work->rules, &work->rules_cap, work->rules_len, sizeof(_odds_rule_t)) != EXIT_SUCCESS)
+                return EXIT_FAILURE;
+
+            _odds_rule_t *rule = &work->rules[work->rules_len];
+            rule->len = 0;
+            rule->need = (int) tile_lo(tile);
+
+            for(size_t sy = (y > 0 ? y - 1 : y); sy <= y + 1 && sy < grid->rows; ++sy)
+            {
+                for(size_t sx = (x > 0 ? x - 1 : x); sx <= x + 1 && sx < grid->cols; ++sx)
+                {
+                    const size_t pos = sy * grid->cols + sx;
+                    const tile_t near = grid->tiles[pos];
+
+                    if(tile_up(near) == REVEALED)
+                    {
+                        rule->need -= (tile_lo(near) == MINE);
+                        continue;
+                    }
+
+                    /* New tile of the frontier */
+                    if(work->var_of[pos] == _ODDS_NONE)
+                    {
+                        if(_odds_grow((void **) &work->vars, &work->vars_cap, work->vars_len, sizeof(size_t)) != EXIT_SUCCESS)
+                            return EXIT_FAILURE;
+
+                        work->var_of[pos] = (uint32_t) work->vars_len;
+                        work->vars[work->vars_len++] = pos;
+                    }
+
+                    rule->vars[rule->len++] = work->var_of[pos];
+                }
+            }
+
+            if(rule->need < 0 || rule->need > rule->len)
+                return EXIT_FAILURE;
+
+            if(rule->len > 0)
+                ++work->rules_len;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Splits the frontier into components, tiles
+ * joined by a number are in the same one.
+ * Components are ordered by their first tile.
+ */
+static int _odds_split(_odds_work_t *work)
+{
+    const size_t vars = work->vars_len;
+    uint32_t *parent = (uint32_t *) malloc(sizeof(uint32_t) * (vars + 1));
+    uint32_t *first = (uint32_t *) malloc(sizeof(uint32_t) * (vars + 1));
+
+    work->comp_of = (uint32_t *) malloc(sizeof(uint32_t) * (vars + 1));
+    work->comp_vars = (size_t *) malloc(sizeof(size_t) * (vars + 1));
+    work->comp_rules = (size_t *) malloc(sizeof(size_t) * (work->rules_len + 1));
+    work->var_start = (size_t *) calloc(vars + 2, sizeof(size_t));
+    work->rule_start = (size_t *) calloc(vars + 2, sizeof(size_t));
+
+    if(! parent || ! first || ! work->comp_of || ! work->comp_vars ||
+       ! work->comp_rules || ! work->var_start || ! work->rule_start)
+    {
+        free(parent);
+        free(first);
+        return EXIT_FAILURE;
+    }
+
+    for(uint32_t v = 0; v < vars; ++v)
+    {
+        parent[v] = v;
+        first[v] = _ODDS_NONE;
+    }
+
+    for(size_t r = 0; r < work->rules_len; ++r)
+    {
+        const _odds_rule_t *rule = &work->rules[r];
+
+        for(uint8_t j = 1; j < rule->len; ++j)
+        {
+            const uint32_t a = _odds_find(parent, rule->vars[0]);
+            const uint32_t b = _odds_find(parent, rule->vars[j]);
+
+            if(a != b)
+                parent[b] = a;
+        }
+    }
+
+    /* Numbering the components */
+    work->comps = 0;
+
+    for(uint32_t v = 0; v < vars; ++v)
+    {
+        const uint32_t root = _odds_find(parent, v);
+
+        if(first[root] == _ODDS_NONE)
+            first[root] = (uint32_t) work->comps++;
+
+        work->comp_of[v] = first[root];
+        ++work->var_start[work->comp_of[v] + 1];
+    }
+
+    for(size_t r = 0; r < work->rules_len; ++r)
+        ++work->rule_start[work->comp_of[work->rules[r].vars[0]] + 1];
+
+    /* Sorting by component (counting) */
+    for(size_t c = 0; c < work->comps; ++c)
+    {
+        work->var_start[c + 1] += work->var_start[c];
+        work->rule_start[c + 1] += work->rule_start[c];
+    }
+
+    for(size_t v = 0, *fill = work->var_start; v < vars; ++v)
+        work->comp_vars[fill[work->comp_of[v]]++] = v;
+
+    for(size_t r = 0, *fill = work->rule_start; r < work->rules_len; ++r)
+        work->comp_rules[fill[work->comp_of[work->rules[r].vars[0]]]++] = r;
+
+    /* Filling moved the starts one component on */
+    memmove(work->var_start + 1, work->var_start, sizeof(size_t) * work->comps);
+    memmove(work->rule_start + 1, work->rule_start, sizeof(size_t) * work->comps);
+    work->var_start[0] = work->rule_start[0] = 0;
+
+    free(parent);
+    free(first);
+
+    return EXIT_SUCCESS;
+}
+
+/* Gets the layouts of every component, from
+ * the cache or by counting them.
+ */
+static int _odds_parts(odds_t *odds, _odds_work_t *work, double deadline)
+{
+    if(! (work->parts = (_odds_part_t *) calloc(work->comps + 1, sizeof(_odds_part_t))))
+        return EXIT_FAILURE;
+
+    _odds_rule_t *rules = (_odds_rule_t *) malloc(sizeof(_odds_rule_t) * (work->rules_len + 1));
+    uint32_t *local = (uint32_t *) malloc(sizeof(uint32_t) * (work->vars_len + 1));
+    size_t *key = (size_t *) malloc(sizeof(size_t) * (work->vars_len + 10 * work->rules_len + 2));
+
+    int status = (rules && local && key) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    for(size_t c = 0; c < work->comps && status == EXIT_SUCCESS; ++c)
+    {
+        const size_t n = work->var_start[c + 1] - work->var_start[c];
+        const size_t rules_len = work->rule_start[c + 1] - work->rule_start[c];
+        size_t key_len = 0;
+
+        /* Key: the tiles, then each number */
+        /* with its tiles given as 0..n-1   */
+        key[key_len++] = n;
+
+        for(size_t i = 0; i < n; ++i)
+        {
+            const size_t v = work->comp_vars[work->var_start[c] + i];
+
+            local[v] = (uint32_t) i;
+            key[key_len++] = work->vars[v];
+        }
+
+        for(size_t i = 0; i < rules_len; ++i)
+        {
+            const _odds_rule_t *rule = &work->rules[work->comp_rules[work->rule_start[c] + i]];
+
+            rules[i].len = rule->len;
+            rules[i].need = rule->need;
+            key[key_len++] = ((size_t) rule->need << 4) | rule->len;
+
+            for(uint8_t j = 0; j < rule->len; ++j)
+                key[key_len++] = rules[i].vars[j] = local[rule->vars[j]];
+        }
+
+        const uint64_t hash = _odds_hash(key, key_len);
+        _odds_entry_t *entry = &odds->cache[hash % ODDS_CACHE_SLOTS];
+
+        /* Counted before */
+        if(entry->key && entry->hash == hash && entry->key_len == key_len &&
+           ! memcmp(entry->key, key, sizeof(size_t) * key_len))
+        {
+            ++odds->hits;
+            status = _odds_part_copy(&work->parts[c], &entry->part);
+            continue;
+        }
+
+        ++odds->misses;
+
+        /* Counting, if not too big and in time */
+        if(n <= ODDS_PART_MAX && _odds_now() < deadline &&
+           _odds_part_alloc(&work->parts[c], n, 0, n + 1) == EXIT_SUCCESS &&
+           _odds_count(rules, rules_len, &work->parts[c], deadline))
+        {
+            /* Kept for later, the old one goes */
+            size_t *copy = (size_t *) malloc(sizeof(size_t) * key_len);
+
+            _odds_part_free(&entry->part);
+            free(entry->key);
+            entry->key = NULL;
+
+            if(copy && _odds_part_copy(&entry->part, &work->parts[c]) == EXIT_SUCCESS)
+            {
+                memcpy(copy, key, sizeof(size_t) * key_len);
+                entry->key = copy;
+                entry->key_len = key_len;
+                entry->hash = hash;
+            }
+            else
+            {
+                _odds_part_free(&entry->part);
+                free(copy);
+            }
+
+            continue;
+        }
+
+        odds->exact = false;
+
+        _odds_part_free(&work->parts[c]);
+        status = _odds_estimate(rules, rules_len, &work->parts[c]);
+    }
+
+    free(rules);
+    free(local);
+    free(key);
+
+    return status;
+}
+
+/* Scales an array so its largest value is 1. */
+static void _odds_scale(double *list, size_t len)
+{
+    double max = 0;
+
+    for(size_t i = 0; i < len; ++i)
+        if(list[i] > max)
+            max = list[i];
+
+    if(max > 0)
+        for(size_t i = 0; i < len; ++i)
+            list[i] /= max;
+}
+
+/* Puts the components together. A total of t
+ * frontier mines weighs as the ways to place
+ * the rest in the other unknown tiles; h[c]
+ * holds, for t mines in components before c,
+ * the weight of all ways to finish from c on.
+ * Scaling cancels out, it is done freely.
+ */
+static int _odds_combine(odds_t *odds, _odds_work_t *work)
+{
+    const grid_t *grid = odds->grid;
+    const size_t frontier = work->vars_len;
+    const size_t inner = work->unknown - frontier;
+    const size_t len = frontier + 1;
+    const size_t comps = work->comps;
+
+    double *h = (double *) calloc((comps + 1) * len, sizeof(double));
+    double *pre = (double *) calloc(len, sizeof(double));
+    double *next = (double *) calloc(len, sizeof(double));
+    double *w = (double *) malloc(sizeof(double) * (frontier + 1));
+
+    if(! h || ! pre || ! next || ! w)
+    {
+        free(h);
+        free(pre);
+        free(next);
+        free(w);
+        return EXIT_FAILURE;
+    }
+
+    /* Ways for the rest: C(inner, mines_left - t) */
+    double *weight = h + comps * len;
+    double top = -INFINITY;
+
+    for(size_t t = 0; t < len; ++t)
+    {
+        if(t > work->mines_left || work->mines_left - t > inner)
+        {
+            weight[t] = -INFINITY;
+            continue;
+        }
+
+        const double m = (double) (work->mines_left - t);
+        weight[t] = lgamma((double) inner + 1) - lgamma(m + 1) - lgamma((double) inner - m + 1);
+
+        if(weight[t] > top)
+            top = weight[t];
+    }
+
+    for(size_t t = 0; t < len; ++t)
+        weight[t] = (weight[t] == -INFINITY) ? 0 : exp(weight[t] - top);
+
+    int status = (top == -INFINITY) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+    /* From the last component back */
+    for(size_t c = comps - 1; status == EXIT_SUCCESS && c + 1 > 1; --c)
+    {
+        const _odds_part_t *part = &work->parts[c];
+        const double *after = h + (c + 1) * len;
+        double *cur = h + c * len;
+
+        for(size_t t = 0; t < len; ++t)
+            for(size_t s = 0; s < part->span && t + part->low + s < len; ++s)
+                cur[t] += part->count[s] * after[t + part->low + s];
+
+        _odds_scale(cur, len);
+    }
+
+    /* Then forward, pre holds the layouts */
+    /* of the components before c          */
+    size_t deg = 0;
+    pre[0] = 1;
+
+    for(size_t c = 0; c < comps && status == EXIT_SUCCESS; ++c)
+    {
+        const _odds_part_t *part = &work->parts[c];
+        const double *after = h + (c + 1) * len;
+        double total = 0;
+
+        for(size_t s = 0; s < part->span; ++s)
+        {
+            w[s] = 0;
+
+            for(size_t a = 0; a <= deg && a + part->low + s < len; ++a)
+                w[s] += pre[a] * after[a + part->low + s];
+
+            total += part->count[s] * w[s];
+        }
+
+        if(total <= 0)
+        {
+            status = EXIT_FAILURE;
+            break;
+        }
+
+        for(size_t v = 0; v < part->n; ++v)
+        {
+            double p = 0;
+
+            for(size_t s = 0; s < part->span; ++s)
+                p += part->tally[s * part->n + v] * w[s];
+
+            odds->prob[work->vars[work->comp_vars[work->var_start[c] + v]]] = p / total;
+        }
+
+        memset(next, 0, sizeof(double) * len);
+
+        for(size_t a = 0; a <= deg; ++a)
+            for(size_t s = 0; s < part->span && a + part->low + s < len; ++s)
+                next[a + part->low + s] += pre[a] * part->count[s];
+
+        deg = (deg + part->low + part->span - 1 < len) ? deg + part->low + part->span - 1 : len - 1;
+
+        double *temp = pre;
+        pre = next;
+        next = temp;
+
+        _odds_scale(pre, deg + 1);
+    }
+
+    /* Tiles away from the numbers */
+    if(status == EXIT_SUCCESS && inner > 0)
+    {
+        double mined = 0, total = 0;
+
+        for(size_t t = 0; t <= deg; ++t)
+        {
+            mined += pre[t] * weight[t] * (double) (work->mines_left - (t < work->mines_left ? t : work->mines_left));
+            total += pre[t] * weight[t];
+        }
+
+        if(total <= 0)
+            status = EXIT_FAILURE;
+
+        for(size_t pos = 0; status == EXIT_SUCCESS && pos < grid->rows * grid->cols; ++pos)
+            if(tile_up(grid->tiles[pos]) != REVEALED && work->var_of[pos] == _ODDS_NONE)
+                odds->prob[pos] = mined / (total * (double) inner);
+    }
+
+    free(h);
+    free(pre);
+    free(next);
+    free(w);
+
+    return status;
+}
+
+
+/* Creates the probabilities of a grid.
+ *
+ *  grid    - the grid
+ *  timeout - time limit of a computation (s),
+ *            0 for ODDS_TIMEOUT_S
+ *
+ *  Returns NULL if failed, valid pointer otherwise.
+ */
+odds_t *new_odds(const grid_t *grid, double timeout)
+{
+    /* Pointer checking */
+    assert(grid);
+
+    odds_t *odds = NULL;
+
+    if(! (odds = (odds_t *) calloc(1, sizeof(odds_t))))
+        return NULL;
+
+    odds->grid = grid;
+    odds->timeout = (timeout > 0) ? timeout : ODDS_TIMEOUT_S;
+    odds->prob = (double *) calloc(grid->rows * grid->cols, sizeof(double));
+    odds->cache = (_odds_entry_t *) calloc(ODDS_CACHE_SLOTS, sizeof(_odds_entry_t));
+
+    if(! odds->prob || ! odds->cache)
+    {
+        del_odds(odds);
+        return NULL;
+    }
+
+    return odds;
+}
+
+/* Computes the chance of mine of every tile,
+ * flags are not taken into account. Revealed
+ * tiles get 0 (1 if a mine).
+ *
+ *  odds    - the probabilities
+ *
+ * Returns 0 if succeeded, 1 if failed or if
+ * the revealed numbers contradict each other.
+ */
+int odds_compute(odds_t *odds)
+{
+    /* Pointer checking */
+    assert(odds);
+
+    const grid_t *grid = odds->grid;
+    const size_t size = grid->rows * grid->cols;
+    const double deadline = _odds_now() + odds->timeout;
+
+    odds->exact = true;
+
+    /* Nothing placed yet, all the same */
+    if(grid->pending)
+    {
+        for(size_t pos = 0; pos < size; ++pos)
+            odds->prob[pos] = (double) grid->mines / (double) size;
+
+        return EXIT_SUCCESS;
+    }
+
+    _odds_work_t work = { .mines_left = grid->mines, };
+
+    for(size_t pos = 0; pos < size; ++pos)
+    {
+        const tile_t tile = grid->tiles[pos];
+        const bool mine = (tile_lo(tile) == MINE);
+
+        odds->prob[pos] = (tile_up(tile) == REVEALED && mine) ? 1 : 0;
+
+        if(tile_up(tile) != REVEALED)
+            ++work.unknown;
+        else if(mine && work.mines_left > 0)
+            --work.mines_left;
+    }
+
+    int status = _odds_rules(grid, &work);
+
+    if(status == EXIT_SUCCESS)
+        status = _odds_split(&work);
+
+    if(status == EXIT_SUCCESS)
+        status = _odds_parts(odds, &work, deadline);
+
+    if(status == EXIT_SUCCESS)
+        status = _odds_combine(odds, &work);
+
+    _odds_work_free(&work);
+
+    return status;
+}
+
+/* Gives the chance of mine of a tile.
+ *
+ *  odds    - the probabilities (computed)
+ *  x, y    - the tile's position
+ */
+double odds_at(const odds_t *odds, size_t x, size_t y)
+{
+    /* Arguments checking */
+    assert(odds && x < odds->grid->cols && y < odds->grid->rows);
+
+    return odds->prob[y * odds->grid->cols + x];
+}
+
+/* Finds the unrevealed, unflagged tile least
+ * likely to be a mine (the first one if more).
+ *
+ *  odds    - the probabilities (computed)
+ *  x, y    - the tile's position
+ *
+ * Returns its chance of mine, -1 if none.
+ */
+double odds_safest(const odds_t *odds, size_t *x, size_t *y)
+{
+    /* Pointer checking */
+    assert(odds && x && y);
+
+    const grid_t *grid = odds->grid;
+    double best = -1;
+
+    for(size_t pos = 0; pos < grid->rows * grid->cols; ++pos)
+    {
+        if(tile_up(grid->tiles[pos]) != UNREVEALED)
+            continue;
+
+        if(best < 0 || odds->prob[pos] < best)
+        {
+            best = odds->prob[pos];
+            *x = pos % grid->cols;
+            *y = pos / grid->cols;
+        }
+    }
+
+    return best;
+}
+
+/* Deletes the probabilities, frees up the memory.
+ *
+ *  odds    - object to be deleted
+ */
+void del_odds(odds_t *odds)
+{
+    if(odds == NULL)
+        return;
+
+    for(size_t i = 0; odds->cache && i < ODDS_CACHE_SLOTS; ++i)
+    {
+        _odds_part_free(&odds->cache[i].part);
+        free(odds->cache[i].key);
+    }
+
+    free(odds->cache);
+    free(odds->prob);
+    free(odds);
+}
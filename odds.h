@@ -0,0 +1,110 @@
+/*
+ *  odds.h
+ *
+ *  Exact mine probability of every tile, from
+ *  what has been revealed and the mine count.
+ *
+ *  The unrevealed tiles next to numbers (the
+ *  frontier) are split into components that
+ *  share no number; the mine layouts of each
+ *  one are counted by backtracking, then the
+ *  components are put together, weighting
+ *  each total of frontier mines by the ways
+ *  the other mines fit in the remaining tiles.
+ *
+ *  Results of components are cached by their
+ *  constraints, so after a move only the
+ *  components it touched are counted again.
+ *  A component too big, or out of time, is
+ *  estimated instead.
+ *
+ */
+
+#ifndef _SAPER_ODDS_H_FILE_
+#define _SAPER_ODDS_H_FILE_
+
+/* Default time limit of a computation (s) */
+#define ODDS_TIMEOUT_S              0.5
+
+/* Slots of the component cache */
+#define ODDS_CACHE_SLOTS            256
+
+/* Largest component (tiles) that is counted */
+#define ODDS_PART_MAX               400
+
+
+#include "grid.h"
+#include "tile.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/* Probabilities of one grid.
+ */
+typedef struct _sap_odds_t
+{
+    const grid_t *grid;                     /* The grid                 */
+    double *prob;                           /* Chance of mine per tile  */
+    double timeout;                         /* Time limit (s)           */
+    bool exact;                             /* Nothing was estimated    */
+
+    struct _sap_odds_entry_t *cache;        /* Counted components       */
+    size_t hits;                            /* Components from cache    */
+    size_t misses;                          /* Components counted       */
+
+} odds_t;
+
+
+/* Creates the probabilities of a grid.
+ *
+ *  grid    - the grid
+ *  timeout - time limit of a computation (s),
+ *            0 for ODDS_TIMEOUT_S
+ *
+ *  Returns NULL if failed, valid pointer otherwise.
+ */
+odds_t      *new_odds(const grid_t *grid, double timeout);
+
+/* Computes the chance of mine of every tile,
+ * flags are not taken into account. Revealed
+ * tiles get 0 (1 if a mine).
+ *
+ *  odds    - the probabilities
+ *
+ * Returns 0 if succeeded, 1 if failed or if
+ * the revealed numbers contradict each other.
+ */
+int         odds_compute(odds_t *odds);
+
+/* Gives the chance of mine of a tile.
+ *
+ *  odds    - the probabilities (computed)
+ *  x, y    - the tile's position
+ */
+double      odds_at(const odds_t *odds, size_t x, size_t y);
+
+/* Finds the unrevealed, unflagged tile least
+ * likely to be a mine (the first one if more).
+ *
+ *  odds    - the probabilities (computed)
+ *  x, y    - the tile's position
+ *
+ * Returns its chance of mine, -1 if none.
+ */
+double      odds_safest(const odds_t *odds, size_t *x, size_t *y);
+
+/* Deletes the probabilities, frees up the memory.
+ *
+ *  odds    - object to be deleted
+ */
+void        del_odds(odds_t *odds);
+
+
+#endif /* _SAPER_ODDS_H_FILE_ */
@@ -0,0 +1,159 @@
+/*
+ *  rng.c
+ *
+ *  Extends 'rng.h'.
+ *
+ */
+
+#include "rng.h"
+
+
+/* Rotates the bits left. */
+static uint64_t _rng_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/* Next splitmix64 value, used for seeding. */
+static uint64_t _rng_splitmix(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15u);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+
+    return z ^ (z >> 31);
+}
+
+
+/* Seeds the generator.
+ *
+ *  rng     - the generator
+ *  seed    - any 64-bit value
+ */
+void rng_seed(rng_t *rng, uint64_t seed)
+{
+    /* Pointer checking */
+    assert(rng);
+
+    /* Never all zeros */
+    for(int i = 0; i < 4; ++i)
+        rng->s[i] = _rng_splitmix(&seed);
+}
+
+/* Seeds the generator and moves it to
+ * the given stream. Streams of one seed
+ * never overlap (2^128 numbers each).
+ * Takes 'stream' jumps, for a few streams.
+ *
+ *  rng     - the generator
+ *  seed    - any 64-bit value
+ *  stream  - stream number
+ */
+void rng_stream(rng_t *rng, uint64_t seed, uint64_t stream)
+{
+    rng_seed(rng, seed);
+
+    for(uint64_t i = 0; i < stream; ++i)
+        rng_jump(rng);
+}
+
+/* Mixes a value into a well spread one
+ * (splitmix64). Gives seeds of numbered
+ * candidates at once, with no jumps.
+ *
+ *  x       - any 64-bit value
+ */
+uint64_t rng_mix(uint64_t x)
+{
+    return _rng_splitmix(&x);
+}
+
+/* Gives next 64 random bits.
+ *
+ *  rng     - the generator
+ */
+uint64_t rng_next(rng_t *rng)
+{
+    /* Pointer checking */
+    assert(rng);
+
+    uint64_t *s = rng->s;
+    const uint64_t result = _rng_rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+
+    s[2] ^= t;
+    s[3] = _rng_rotl(s[3], 45);
+
+    return result;
+}
+
+/* Gives unbiased random number
+ * from [0, bound).
+ *
+ *  rng     - the generator
+ *  bound   - the limit, > 0
+ */
+uint64_t rng_below(rng_t *rng, uint64_t bound)
+{
+    assert(bound > 0);
+
+    /* Values below 'threshold' would make
+     * the small results more likely */
+    const uint64_t threshold = (0u - bound) % bound;
+    uint64_t r;
+
+    do
+        r = rng_next(rng);
+    while(r < threshold);
+
+    return r % bound;
+}
+
+/* Moves the generator 2^128 steps ahead.
+ *
+ *  rng     - the generator
+ */
+void rng_jump(rng_t *rng)
+{
+    static const uint64_t jump[4] =
+    {
+        0x180EC6D33CFD0ABAu, 0xD5A61266F0C9392Cu,
+        0xA9582618E03FC9AAu, 0x39ABDC4529B1661Cu
+    };
+
+    uint64_t s[4] = {0, };
+
+    for(int i = 0; i < 4; ++i)
+    {
+        for(int b = 0; b < 64; ++b)
+        {
+            if(jump[i] & ((uint64_t) 1 << b))
+            {
+                for(int k = 0; k < 4; ++k)
+                    s[k] ^= rng->s[k];
+            }
+
+            rng_next(rng);
+        }
+    }
+
+    for(int k = 0; k < 4; ++k)
+        rng->s[k] = s[k];
+}
+
+/* Gives a seed based on the current time,
+ * never 0.
+ */
+uint64_t rng_time_seed(void)
+{
+    uint64_t x = ((uint64_t) time(NULL) << 20) ^ (uint64_t) clock();
+    uint64_t seed = _rng_splitmix(&x);
+
+    return seed ? seed : 1u;
+}
@@ -0,0 +1,81 @@
+/*
+ *  rng.h
+ *
+ *  Pseudo-random number generator
+ *  (xoshiro256**, seeded with splitmix64).
+ *  Same numbers on every platform, no
+ *  global state - each user owns a generator.
+ *  Streams for parallel use are made
+ *  with jumps of 2^128 steps.
+ *
+ */
+
+#ifndef _SAPER_RNG_H_FILE_
+#define _SAPER_RNG_H_FILE_
+
+#include <assert.h>
+#include <stdint.h>
+#include <time.h>
+
+
+/* Generator state. */
+typedef struct _sap_rng_t
+{
+    uint64_t s[4];
+
+} rng_t;
+
+
+/* Seeds the generator.
+ *
+ *  rng     - the generator
+ *  seed    - any 64-bit value
+ */
+void        rng_seed(rng_t *rng, uint64_t seed);
+
+/* Seeds the generator and moves it to
+ * the given stream. Streams of one seed
+ * never overlap (2^128 numbers each).
+ * Takes 'stream' jumps, for a few streams.
+ *
+ *  rng     - the generator
+ *  seed    - any 64-bit value
+ *  stream  - stream number
+ */
+void        rng_stream(rng_t *rng, uint64_t seed, uint64_t stream);
+
+/* Mixes a value into a well spread one
+ * (splitmix64). Gives seeds of numbered
+ * candidates at once, with no jumps.
+ *
+ *  x       - any 64-bit value
+ */
+uint64_t    rng_mix(uint64_t x);
+
+/* Gives next 64 random bits.
+ *
+ *  rng     - the generator
+ */
+uint64_t    rng_next(rng_t *rng);
+
+/* Gives unbiased random number
+ * from [0, bound).
+ *
+ *  rng     - the generator
+ *  bound   - the limit, > 0
+ */
+uint64_t    rng_below(rng_t *rng, uint64_t bound);
+
+/* Moves the generator 2^128 steps ahead.
+ *
+ *  rng     - the generator
+ */
+void        rng_jump(rng_t *rng);
+
+/* Gives a seed based on the current time,
+ * never 0.
+ */
+uint64_t    rng_time_seed(void);
+
+
+#endif /* _SAPER_RNG_H_FILE_ */
@@ -0,0 +1,411 @@
+/*
+ *  sim.c
+ *
+ *  Entry point of the simulator,
+ *  extends 'sim.h'.
+ *
+ */
+
+#include "sim.h"
+
+
+/* Current time in nanoseconds. */
+static uint64_t _sim_now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Histogram bucket of a latency. */
+static size_t _sim_bucket(uint64_t ns)
+{
+    if(ns < SIM_HIST_SUB)
+        return (size_t) ns;
+
+    const int top = 63 - __builtin_clzll(ns);
+
+    return (size_t) (top - 3) * SIM_HIST_SUB + (size_t) ((ns >> (top - 4)) & (SIM_HIST_SUB - 1));
+}
+
+/* Lowest latency of a bucket. */
+static uint64_t _sim_bucket_low(size_t bucket)
+{
+    if(bucket < SIM_HIST_SUB)
+        return (uint64_t) bucket;
+
+    const size_t top = bucket / SIM_HIST_SUB + 3;
+
+    return (uint64_t) (SIM_HIST_SUB + bucket % SIM_HIST_SUB) << (top - 4);
+}
+
+/* Random unrevealed tile, not a known mine. */
+static void _sim_guess(sim_player_t *player, size_t *x, size_t *y)
+{
+    const grid_t *grid = player->grid;
+    size_t pos;
+
+    do
+        pos = (size_t) rng_below(&player->rng, grid->rows * grid->cols);
+    while(tile_up(grid->tiles[pos]) != UNREVEALED ||
+          (player->solver && solver_known(player->solver, pos % grid->cols, pos / grid->cols) == MINED));
+
+    *x = pos % grid->cols;
+    *y = pos / grid->cols;
+}
+
+/* Bot: any tile. */
+static void _sim_bot_random(sim_player_t *player, size_t *x, size_t *y)
+{
+    _sim_guess(player, x, y);
+}
+
+/* Bot: sure moves, random guesses. */
+static void _sim_bot_solver(sim_player_t *player, size_t *x, size_t *y)
+{
+    if(solver_hint(player->solver, x, y) != SAFE)
+        _sim_guess(player, x, y);
+}
+
+/* Bot: sure moves, the least risky guesses. */
+static void _sim_bot_odds(sim_player_t *player, size_t *x, size_t *y)
+{
+    if(solver_hint(player->solver, x, y) == SAFE)
+        return;
+
+    if(odds_compute(player->odds) != EXIT_SUCCESS || odds_safest(player->odds, x, y) < 0)
+        _sim_guess(player, x, y);
+}
+
+/* Known bots */
+static const sim_bot_t g_bots[] =
+{
+    { "random", _sim_bot_random, false, false },
+    { "solver", _sim_bot_solver, true, false },
+    { "odds",   _sim_bot_odds,   true, true },
+};
+
+/* Difficulties, as in the game */
+static const sim_level_t g_levels[] =
+{
+    { 'L', 9, 9, 10 },
+    { 'N', 16, 16, 40 },
+    { 'T', 16, 30, 99 },
+};
+
+
+/* Plays one game on the player's grid,
+ * reset for it.
+ *
+ *  player  - the player (its grid fits the level)
+ *  level   - the difficulty
+ *  bot     - the bot
+ *  seed    - seed of the simulation
+ *  index   - the game's number
+ *  result  - results to add to
+ */
+void sim_play(sim_player_t *player, const sim_level_t *level, const sim_bot_t *bot, uint64_t seed, size_t index, sim_result_t *result)
+{
+    /* Pointer checking */
+    assert(player && player->grid && level && bot && result);
+
+    /* The game's own generator: board, then guesses */
+    /* (rng_seed mixes the seed, level and index)     */
+    rng_seed(&player->rng, seed + ((uint64_t) level->name << 56) + (uint64_t) index * 0x9E3779B97F4A7C15ULL);
+
+    const uint64_t board = rng_next(&player->rng);
+
+    /* The solver starts over at the log's gap, */
+    /* the odds keep their cache of components  */
+    grid_reset(player->grid, board ? board : 1);
+
+    /* 1st move in the middle, opens an area */
+    size_t x = level->cols / 2;
+    size_t y = level->rows / 2;
+    stats_t stats;
+
+    uint64_t start = _sim_now();
+    bool alive = (grid_reveal(player->grid, x, y) != (size_t) -1);
+
+    while(true)
+    {
+        if(player->solver)
+            solver_update(player->solver);
+
+        grid_log_clear(player->grid);
+
+        const uint64_t end = _sim_now();
+        ++result->hist[_sim_bucket(end - start)];
+        ++result->moves;
+
+        if(end - start > result->max)
+            result->max = end - start;
+
+        if(! alive || grid_won(player->grid))
+            break;
+
+        start = end;
+
+        bot->move(player, &x, &y);
+        alive = (grid_reveal(player->grid, x, y) != (size_t) -1);
+    }
+
+    ++result->games;
+    result->wins += alive;
+
+    /* The board is placed by the 1st move */
+    if(stats_compute(player->grid, 0, &stats) == EXIT_SUCCESS)
+        result->bbbv += stats.bbbv;
+}
+
+/* Plays the games of a worker, all with
+ * one grid, solver and odds.
+ *
+ *  job     - the worker's job (sim_job_t)
+ */
+void *sim_work(void *job)
+{
+    /* Pointer checking */
+    assert(job);
+
+    sim_job_t *work = (sim_job_t *) job;
+    const sim_level_t *level = work->level;
+    const sim_bot_t *bot = work->bot;
+
+    sim_player_t player = {0, };
+
+    player.grid = new_grid_deferred(level->rows, level->cols, level->mines, 1);
+    player.solver = (player.grid && bot->solver) ? new_solver(player.grid) : NULL;
+    player.odds = (player.grid && bot->odds) ? new_odds(player.grid, SIM_ODDS_TIMEOUT_S) : NULL;
+
+    /* No games if out of memory */
+    if(player.grid && (! bot->solver || player.solver) && (! bot->odds || player.odds))
+        for(size_t i = work->first; i < work->games; i += work->step)
+            sim_play(&player, level, bot, work->seed, i, &work->result);
+
+    del_odds(player.odds);
+    del_solver(player.solver);
+    del_grid(player.grid);
+
+    return NULL;
+}
+
+/* Gives the latency below which a share of
+ * the moves were made.
+ *
+ *  result  - the results
+ *  share   - the share (0.5 for the median)
+ *
+ * Returns the latency in ns.
+ */
+uint64_t sim_percentile(const sim_result_t *result, double share)
+{
+    /* Pointer checking */
+    assert(result);
+
+    const double goal = share * (double) result->moves;
+    size_t seen = 0;
+
+    for(size_t b = 0; b < SIM_HIST_LEN; ++b)
+    {
+        seen += result->hist[b];
+
+        if(seen > 0 && (double) seen >= goal)
+            return _sim_bucket_low(b);
+    }
+
+    return 0;
+}
+
+/* Displays help. */
+void help(void)
+{
+    printf("\n Uzycie:\n\n\t./saper-sim.out <opcjonalne flagi>\n\n");
+    printf(" Flagi:\n\n");
+    printf(" h            - wyswietla pomoc\n"
+           " n <ilosc>    - gier na trudnosc (domyslnie %d)\n"
+           " t <ilosc>    - watkow (domyslnie jeden na procesor)\n"
+           " b <bot>      - random, solver lub odds (domyslnie solver)\n"
+           " p <poziomy>  - trudnosci, np. LT (domyslnie %s)\n"
+           " z <wartosc>  - ustawia ziarno generatora\n\n", SIM_GAMES, SIM_LEVELS);
+
+    exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+
+    /* Simulation settings */
+    size_t games = SIM_GAMES;
+    size_t workers = 0;
+    uint64_t seed = 0;
+    const sim_bot_t *bot = &g_bots[1];
+    const char *levels = SIM_LEVELS;
+
+    while((opt = getopt(argc, argv, "hn:t:b:p:z:")) != EOF)
+    {
+        switch(opt)
+        {
+            case 'h':
+                help();
+                break;
+
+            case 'n':
+                games = (size_t) strtoull(optarg, NULL, 0);
+                break;
+
+            case 't':
+                workers = (size_t) strtoull(optarg, NULL, 0);
+                break;
+
+            case 'b':
+            {
+                bot = NULL;
+
+                for(size_t i = 0; i < sizeof(g_bots) / sizeof(g_bots[0]); ++i)
+                    if(strcmp(optarg, g_bots[i].name) == 0)
+                        bot = &g_bots[i];
+
+                if(! bot)
+                {
+                    fprintf(stderr, "-b: Nieznany bot.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+
+            case 'p':
+                levels = optarg;
+                break;
+
+            case 'z':
+                seed = strtoull(optarg, NULL, 0);
+                break;
+
+            default:
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if(seed == 0)
+        seed = rng_time_seed();
+
+#ifdef SIM_PTHREAD
+    if(workers == 0)
+    {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = (cpus > 0) ? (size_t) cpus : 1;
+    }
+#else
+    workers = 1;
+#endif
+
+    sim_job_t *jobs = (sim_job_t *) malloc(sizeof(sim_job_t) * workers);
+
+#ifdef SIM_PTHREAD
+    pthread_t *threads = (pthread_t *) malloc(sizeof(pthread_t) * workers);
+#else
+    void *threads = jobs;
+#endif
+
+    if(! jobs || ! threads)
+    {
+        fprintf(stderr, "Brak pamieci.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Bot: %s  watki: %zu  gier: %zu  ziarno: %llu\n\n", bot->name, workers, games, (unsigned long long) seed);
+
+    for(const char *l = levels; *l; ++l)
+    {
+        const sim_level_t *level = NULL;
+
+        for(size_t i = 0; i < sizeof(g_levels) / sizeof(g_levels[0]); ++i)
+            if(toupper(*l) == g_levels[i].name)
+                level = &g_levels[i];
+
+        if(! level)
+        {
+            fprintf(stderr, "-p: Nieznana trudnosc '%c'.\n", *l);
+            continue;
+        }
+
+        const uint64_t start = _sim_now();
+
+        for(size_t w = 0; w < workers; ++w)
+        {
+            memset(&jobs[w], 0, sizeof(sim_job_t));
+            jobs[w].level = level;
+            jobs[w].bot = bot;
+            jobs[w].seed = seed;
+            jobs[w].first = w;
+            jobs[w].step = workers;
+            jobs[w].games = games;
+
+#ifdef SIM_PTHREAD
+            /* Played here if no thread */
+            if(pthread_create(&threads[w], NULL, sim_work, &jobs[w]) != 0)
+            {
+                threads[w] = pthread_self();
+                sim_work(&jobs[w]);
+            }
+#else
+            sim_work(&jobs[w]);
+#endif
+        }
+
+        /* Summing the workers up */
+        sim_result_t *total = (sim_result_t *) calloc(1, sizeof(sim_result_t));
+        if(! total)
+        {
+            fprintf(stderr, "Brak pamieci.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for(size_t w = 0; w < workers; ++w)
+        {
+#ifdef SIM_PTHREAD
+            if(! pthread_equal(threads[w], pthread_self()))
+                pthread_join(threads[w], NULL);
+#endif
+            const sim_result_t *part = &jobs[w].result;
+
+            total->games += part->games;
+            total->wins += part->wins;
+            total->bbbv += part->bbbv;
+            total->moves += part->moves;
+
+            if(part->max > total->max)
+                total->max = part->max;
+
+            for(size_t b = 0; b < SIM_HIST_LEN; ++b)
+                total->hist[b] += part->hist[b];
+        }
+
+        const double seconds = (double) (_sim_now() - start) * 1e-9;
+        const double count = total->games ? (double) total->games : 1;
+
+        printf("%c %zux%zu/%zu: gier %zu  wygrane %.2f%%  sr. 3BV %.1f  %.0f gier/s\n",
+               level->name, level->rows, level->cols, level->mines, total->games,
+               100.0 * (double) total->wins / count, (double) total->bbbv / count,
+               seconds > 0 ? (double) total->games / seconds : 0);
+
+        printf("  ruch (ns): p50 %llu  p90 %llu  p99 %llu  p99.9 %llu  max %llu\n\n",
+               (unsigned long long) sim_percentile(total, 0.5),
+               (unsigned long long) sim_percentile(total, 0.9),
+               (unsigned long long) sim_percentile(total, 0.99),
+               (unsigned long long) sim_percentile(total, 0.999),
+               (unsigned long long) total->max);
+
+        free(total);
+    }
+
+#ifdef SIM_PTHREAD
+    free(threads);
+#endif
+    free(jobs);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+/*
+ *  sim.h
+ *
+ *  Headless simulator: bots play many games
+ *  of each difficulty, spread over worker
+ *  threads, without any drawing. Built as
+ *  its own program (make saper-sim), with
+ *  the grid code only.
+ *
+ *  Game i of a difficulty has its own
+ *  generator, seeded from the seed, the
+ *  difficulty and i (board and bot's
+ *  choices), so the results do not depend
+ *  on the number of workers.
+ *
+ */
+
+#ifndef _SAPER_SIM_H_FILE_
+#define _SAPER_SIM_H_FILE_
+
+/* Defaults */
+#define SIM_GAMES                   10000
+#define SIM_LEVELS                  "LNT"
+
+/* Time limit of the probabilities (s), high
+ * so they are not estimated under load */
+#define SIM_ODDS_TIMEOUT_S          60.0
+
+/* Latency histogram: exact below 16 ns, then
+ * 16 buckets per power of 2 (~6% wide) */
+#define SIM_HIST_SUB                16
+#define SIM_HIST_LEN                (61 * SIM_HIST_SUB)
+
+/* Workers are threads */
+#ifdef __linux__
+    #define SIM_PTHREAD
+#endif
+
+
+#include "grid.h"
+#include "odds.h"
+#include "rng.h"
+#include "solver.h"
+#include "stats.h"
+#include "tile.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef SIM_PTHREAD
+    #include <pthread.h>
+#endif
+
+
+/* A difficulty. */
+typedef struct _sap_sim_level_t
+{
+    char name;
+    size_t rows;
+    size_t cols;
+    size_t mines;
+
+} sim_level_t;
+
+/* State of a bot in one game. */
+typedef struct _sap_sim_player_t
+{
+    grid_t *grid;
+    solver_t *solver;                       /* NULL if not used         */
+    odds_t *odds;                           /* NULL if not used         */
+    rng_t rng;                              /* For guesses              */
+
+} sim_player_t;
+
+/* A bot: gives the next tile to reveal. */
+typedef void (*sim_move_t)(sim_player_t *player, size_t *x, size_t *y);
+
+/* A bot, by name. */
+typedef struct _sap_sim_bot_t
+{
+    const char *name;
+    sim_move_t move;
+    bool solver;                            /* Needs the solver         */
+    bool odds;                              /* Needs the probabilities  */
+
+} sim_bot_t;
+
+/* Results of games, summed. */
+typedef struct _sap_sim_result_t
+{
+    size_t games;
+    size_t wins;
+    size_t bbbv;                            /* 3BV of all boards        */
+    size_t moves;
+    uint64_t hist[SIM_HIST_LEN];            /* Move latencies (ns)      */
+    uint64_t max;                           /* Slowest move (ns)        */
+
+} sim_result_t;
+
+/* Games of one worker. */
+typedef struct _sap_sim_job_t
+{
+    const sim_level_t *level;
+    const sim_bot_t *bot;
+    uint64_t seed;
+    size_t first;                           /* Then every 'step'th      */
+    size_t step;
+    size_t games;
+    sim_result_t result;
+
+} sim_job_t;
+
+
+/* Plays one game on the player's grid,
+ * reset for it.
+ *
+ *  player  - the player (its grid fits the level)
+ *  level   - the difficulty
+ *  bot     - the bot
+ *  seed    - seed of the simulation
+ *  index   - the game's number
+ *  result  - results to add to
+ */
+void        sim_play(sim_player_t *player, const sim_level_t *level, const sim_bot_t *bot, uint64_t seed, size_t index, sim_result_t *result);
+
+/* Plays the games of a worker, all with
+ * one grid, solver and odds.
+ *
+ *  job     - the worker's job (sim_job_t)
+ */
+void        *sim_work(void *job);
+
+/* Gives the latency below which a share of
+ * the moves were made.
+ *
+ *  result  - the results
+ *  share   - the share (0.5 for the median)
+ *
+ * Returns the latency in ns.
+ */
+uint64_t    sim_percentile(const sim_result_t *result, double share);
+
+
+#endif /* _SAPER_SIM_H_FILE_ */
@@ -0,0 +1,566 @@
+/*
+ *  solver.c
+ *
+ *  Extends 'solver.h'.
+ *
+ */
+
+#include "solver.h"
+
+
+/* Candidates shared by the workers. */
+typedef struct _sap_solver_search_t
+{
+    const grid_t *grid;                     /* Size, mines and seed     */
+    size_t x, y;                            /* First tile               */
+    size_t workers;
+    size_t best;                            /* Lowest solvable so far   */
+    double deadline;                        /* Time to stop, 0 if none  */
+
+#ifdef SOLVER_PTHREAD
+    pthread_mutex_t lock;
+#endif
+
+} _solver_search_t;
+
+/* A worker and its candidates. */
+typedef struct _sap_solver_worker_t
+{
+    _solver_search_t *search;
+    size_t first;                           /* Then every 'workers'th   */
+
+} _solver_worker_t;
+
+/* Unknown tiles around a number (at most 8). */
+typedef struct _sap_solver_near_t
+{
+    size_t pos[8];
+    size_t count;
+    int left;                               /* Mines not found yet      */
+
+} _solver_near_t;
+
+
+/* Value of a revealed number, -1 for any other tile.
+ * Nothing else of the grid is ever looked at.
+ */
+static int _solver_number(const solver_t *solver, size_t pos)
+{
+    const tile_t tile = solver->grid->tiles[pos];
+
+    if(tile_up(tile) != REVEALED || tile_lo(tile) == D0 || tile_lo(tile) == MINE)
+        return -1;
+
+    return (int) tile_lo(tile);
+}
+
+/* Queues a number to be looked at. */
+static void _solver_queue(solver_t *solver, size_t pos)
+{
+    if(solver->queued[pos] || _solver_number(solver, pos) < 0)
+        return;
+
+    solver->queued[pos] = 1;
+    solver->queue[solver->queue_len++] = pos;
+}
+
+/* Queues the numbers around a tile (and itself). */
+static void _solver_queue_near(solver_t *solver, size_t pos)
+{
+    const grid_t *grid = solver->grid;
+    const size_t x = pos % grid->cols;
+    const size_t y = pos / grid->cols;
+
+    for(size_t sy = (y > 0 ? y - 1 : y); sy <= y + 1 && sy < grid->rows; ++sy)
+        for(size_t sx = (x > 0 ? x - 1 : x); sx <= x + 1 && sx < grid->cols; ++sx)
+            _solver_queue(solver, sy * grid->cols + sx);
+}
+
+/* Unknown tiles and mines left around a number. */
+static void _solver_near(const solver_t *solver, size_t pos, _solver_near_t *near)
+{
+    const grid_t *grid = solver->grid;
+    const size_t x = pos % grid->cols;
+    const size_t y = pos / grid->cols;
+
+    near->count = 0;
+    near->left = _solver_number(solver, pos);
+
+    for(size_t sy = (y > 0 ? y - 1 : y); sy <= y + 1 && sy < grid->rows; ++sy)
+    {
+        for(size_t sx = (x > 0 ? x - 1 : x); sx <= x + 1 && sx < grid->cols; ++sx)
+        {
+            const size_t next = sy * grid->cols + sx;
+            const tile_t tile = grid->tiles[next];
+
+            /* A revealed mine ends the game, */
+            /* but it is a mine all the same  */
+            if(solver->known[next] == MINED || (tile_up(tile) == REVEALED && tile_lo(tile) == MINE))
+                --near->left;
+
+            else if(tile_up(tile) != REVEALED && solver->known[next] == UNKNOWN)
+                near->pos[near->count++] = next;
+        }
+    }
+}
+
+/* Notes what a tile is, the numbers
+ * around it will be looked at again.
+ */
+static void _solver_mark(solver_t *solver, size_t pos, known_t what)
+{
+    if(solver->known[pos] != UNKNOWN)
+        return;
+
+    solver->known[pos] = (uint8_t) what;
+
+    if(what == SAFE)
+        solver->safe[solver->safe_len++] = pos;
+    else
+        solver->mines[solver->mines_len++] = pos;
+
+    _solver_queue_near(solver, pos);
+}
+
+/* Marks the tiles of 'a' missing in 'b'. */
+static void _solver_mark_diff(solver_t *solver, const _solver_near_t *a, const _solver_near_t *b, known_t what)
+{
+    for(size_t i = 0; i < a->count; ++i)
+    {
+        bool shared = false;
+
+        for(size_t j = 0; j < b->count && ! shared; ++j)
+            shared = (a->pos[i] == b->pos[j]);
+
+        if(! shared)
+            _solver_mark(solver, a->pos[i], what);
+    }
+}
+
+/* Counts the tiles of 'a' missing in 'b'. */
+static size_t _solver_count_diff(const _solver_near_t *a, const _solver_near_t *b)
+{
+    size_t count = a->count;
+
+    for(size_t i = 0; i < a->count; ++i)
+        for(size_t j = 0; j < b->count; ++j)
+            if(a->pos[i] == b->pos[j])
+                --count;
+
+    return count;
+}
+
+/* Applies the rules to a number. */
+static void _solver_look(solver_t *solver, size_t pos)
+{
+    const grid_t *grid = solver->grid;
+    _solver_near_t a;
+
+    _solver_near(solver, pos, &a);
+
+    if(a.count == 0)
+        return;
+
+    /* All the mines found, or all unknown are mines */
+    if(a.left == 0 || a.left == (int) a.count)
+    {
+        for(size_t i = 0; i < a.count; ++i)
+            _solver_mark(solver, a.pos[i], (a.left == 0) ? SAFE : MINED);
+
+        return;
+    }
+
+    /* Pairs with numbers up to 2 tiles away: if the  */
+    /* tiles only 'b' has must hold all the mines 'b' */
+    /* has more, they are mines and the tiles only    */
+    /* 'a' has are safe                               */
+    const size_t x = pos % grid->cols;
+    const size_t y = pos / grid->cols;
+
+    for(size_t sy = (y > 1 ? y - 2 : 0); sy <= y + 2 && sy < grid->rows; ++sy)
+    {
+        for(size_t sx = (x > 1 ? x - 2 : 0); sx <= x + 2 && sx < grid->cols; ++sx)
+        {
+            const size_t other = sy * grid->cols + sx;
+            if(other == pos || _solver_number(solver, other) < 0)
+                continue;
+
+            _solver_near_t b;
+            _solver_near(solver, other, &b);
+
+            if(b.count == 0)
+                continue;
+
+            const size_t only_a = _solver_count_diff(&a, &b);
+            const size_t only_b = _solver_count_diff(&b, &a);
+
+            if(b.left - a.left == (int) only_b && (only_a || only_b))
+            {
+                _solver_mark_diff(solver, &b, &a, MINED);
+                _solver_mark_diff(solver, &a, &b, SAFE);
+                return;
+            }
+
+            if(a.left - b.left == (int) only_a && (only_a || only_b))
+            {
+                _solver_mark_diff(solver, &a, &b, MINED);
+                _solver_mark_diff(solver, &b, &a, SAFE);
+                return;
+            }
+        }
+    }
+}
+
+/* Seed of candidate i, never 0 (a time seed).
+ * Made at once, whatever i is. Candidate 0
+ * is the seed itself. */
+static uint64_t _solver_seed(uint64_t seed, size_t i)
+{
+    if(i == 0)
+        return seed;
+
+    const uint64_t next = rng_mix(seed ^ rng_mix((uint64_t) i));
+    return next ? next : 1;
+}
+
+/* Current time in seconds. */
+static double _solver_now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Lowest solvable candidate found so far. */
+static size_t _solver_best(_solver_search_t *search)
+{
+#ifdef SOLVER_PTHREAD
+    pthread_mutex_lock(&search->lock);
+    const size_t best = search->best;
+    pthread_mutex_unlock(&search->lock);
+
+    return best;
+#else
+    return search->best;
+#endif
+}
+
+/* Tries the candidates of a worker, in order,
+ * while they are below the best one found.
+ */
+static void *_solver_work(void *arg)
+{
+    _solver_worker_t *worker = (_solver_worker_t *) arg;
+    _solver_search_t *search = worker->search;
+    const grid_t *grid = search->grid;
+
+    for(size_t i = worker->first; i < _solver_best(search); i += search->workers)
+    {
+        /* Out of time, the rest is not tried */
+        if(search->deadline > 0 && _solver_now() > search->deadline)
+            break;
+
+        grid_t *candidate = new_grid_deferred(grid->rows, grid->cols, grid->mines, _solver_seed(grid->seed, i));
+        if(! candidate)
+            break;
+
+        const bool solved = solver_solves(candidate, search->x, search->y);
+        del_grid(candidate);
+
+        if(! solved)
+            continue;
+
+#ifdef SOLVER_PTHREAD
+        pthread_mutex_lock(&search->lock);
+#endif
+        if(i < search->best)
+            search->best = i;
+#ifdef SOLVER_PTHREAD
+        pthread_mutex_unlock(&search->lock);
+#endif
+        break;
+    }
+
+    return NULL;
+}
+
+
+/* Creates a solver following the grid.
+ *
+ *  grid    - the grid
+ *
+ *  Returns NULL if failed, valid pointer otherwise.
+ */
+solver_t *new_solver(const grid_t *grid)
+{
+    /* Pointer checking */
+    assert(grid);
+
+    const size_t size = grid->rows * grid->cols;
+    solver_t *solver = NULL;
+
+    if(! (solver = (solver_t *) calloc(1, sizeof(solver_t))))
+        return NULL;
+
+    solver->grid = grid;
+    solver->fresh = true;
+
+    /* Every tile is queued or found once at most */
+    solver->known = (uint8_t *) calloc(size, sizeof(uint8_t));
+    solver->queued = (uint8_t *) calloc(size, sizeof(uint8_t));
+    solver->queue = (size_t *) malloc(sizeof(size_t) * size);
+    solver->safe = (size_t *) malloc(sizeof(size_t) * size);
+    solver->mines = (size_t *) malloc(sizeof(size_t) * size);
+
+    if(! solver->known || ! solver->queued || ! solver->queue ||
+       ! solver->safe || ! solver->mines)
+    {
+        del_solver(solver);
+        return NULL;
+    }
+
+    return solver;
+}
+
+/* Reads the grid's changes since the last
+ * update and finds what follows from them.
+ * The whole grid is read the first time,
+ * or if the log has a gap.
+ *
+ *  solver  - the solver
+ */
+void solver_update(solver_t *solver)
+{
+    /* Pointer checking */
+    assert(solver);
+
+    const grid_t *grid = solver->grid;
+    const size_t size = grid->rows * grid->cols;
+
+    /* Changes missed, starting over */
+    if(solver->fresh || solver->log_pos < grid->log_base)
+    {
+        memset(solver->known, UNKNOWN, size);
+        memset(solver->queued, 0, size);
+        solver->queue_len = solver->safe_len = solver->mines_len = 0;
+
+        for(size_t pos = 0; pos < size; ++pos)
+            _solver_queue(solver, pos);
+
+        solver->fresh = false;
+    }
+    else
+    {
+        /* Numbers around the changed tiles */
+        for(size_t i = solver->log_pos - grid->log_base; i < grid->log_len; ++i)
+            _solver_queue_near(solver, grid->log[i]);
+    }
+
+    solver->log_pos = grid->log_base + grid->log_len;
+
+    while(solver->queue_len > 0)
+    {
+        const size_t pos = solver->queue[--solver->queue_len];
+
+        solver->queued[pos] = 0;
+        _solver_look(solver, pos);
+    }
+}
+
+/* Gives a move certainly right: a safe tile
+ * to reveal or, if none, a mine to flag.
+ *
+ *  solver  - the solver (updated)
+ *  x, y    - the tile's position
+ *
+ * Returns SAFE or MINED, UNKNOWN if there is
+ * no such move.
+ */
+known_t solver_hint(solver_t *solver, size_t *x, size_t *y)
+{
+    /* Pointer checking */
+    assert(solver && x && y);
+
+    const grid_t *grid = solver->grid;
+
+    /* Revealed ones are of no use any more */
+    while(solver->safe_len > 0 && tile_up(grid->tiles[solver->safe[solver->safe_len - 1]]) == REVEALED)
+        --solver->safe_len;
+
+    if(solver->safe_len > 0)
+    {
+        *x = solver->safe[solver->safe_len - 1] % grid->cols;
+        *y = solver->safe[solver->safe_len - 1] / grid->cols;
+
+        return SAFE;
+    }
+
+    /* Flagged mines stay, a flag can be taken back */
+    for(size_t i = solver->mines_len; i > 0; --i)
+    {
+        if(tile_up(grid->tiles[solver->mines[i - 1]]) != UNREVEALED)
+            continue;
+
+        *x = solver->mines[i - 1] % grid->cols;
+        *y = solver->mines[i - 1] / grid->cols;
+
+        return MINED;
+    }
+
+    return UNKNOWN;
+}
+
+/* Gives what is known about a tile.
+ *
+ *  solver  - the solver (updated)
+ *  x, y    - the tile's position
+ */
+known_t solver_known(const solver_t *solver, size_t x, size_t y)
+{
+    /* Arguments checking */
+    assert(solver && x < solver->grid->cols && y < solver->grid->rows);
+
+    return (known_t) solver->known[y * solver->grid->cols + x];
+}
+
+/* Plays a grid from a tile on with the
+ * solver's moves only.
+ *
+ *  grid    - the grid (changed)
+ *  x, y    - the first tile
+ *
+ * Returns true if the grid was won.
+ */
+bool solver_solves(grid_t *grid, size_t x, size_t y)
+{
+    /* Pointer checking */
+    assert(grid);
+
+    solver_t *solver = new_solver(grid);
+    if(! solver)
+        return false;
+
+    bool alive = (grid_reveal(grid, x, y) != (size_t) -1);
+
+    while(alive && ! grid_won(grid))
+    {
+        size_t sx, sy;
+
+        solver_update(solver);
+        grid_log_clear(grid);
+
+        /* A guess would be needed */
+        if(solver_hint(solver, &sx, &sy) != SAFE)
+            break;
+
+        alive = (grid_reveal(grid, sx, sy) != (size_t) -1);
+    }
+
+    del_solver(solver);
+
+    return alive && grid_won(grid);
+}
+
+/* Chooses the seed of a deferred grid so
+ * that it is won without guessing when
+ * started at a given tile. Candidate 0 is
+ * grid->seed itself, candidate i has its
+ * own seed (grid->seed and i mixed), so a
+ * seed found plays the same board again.
+ * The workers try them side by side and the
+ * lowest solvable one is taken, whatever
+ * the number of workers (unless the time
+ * runs out first).
+ *
+ *  grid    - the grid (mines not placed)
+ *  x, y    - the first tile
+ *  workers - no. of workers, 0 for one per CPU
+ *  seconds - time limit, 0 for none
+ *
+ * Returns 0 if found (grid->seed is the new
+ * seed, the mines are placed by the first
+ * reveal), 1 if none of SOLVER_TRIES was
+ * or the time ran out.
+ */
+int solver_no_guess(grid_t *grid, size_t x, size_t y, size_t workers, double seconds)
+{
+    /* Arguments checking */
+    assert(grid && grid->pending && x < grid->cols && y < grid->rows);
+
+    _solver_search_t search = { .grid = grid, .x = x, .y = y, .best = SOLVER_TRIES,
+                                .deadline = (seconds > 0) ? _solver_now() + seconds : 0, };
+
+#ifdef SOLVER_PTHREAD
+    if(workers == 0)
+    {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = (cpus > 0) ? (size_t) cpus : 1;
+    }
+
+    pthread_t *threads = (pthread_t *) malloc(sizeof(pthread_t) * workers);
+    _solver_worker_t *list = (_solver_worker_t *) malloc(sizeof(_solver_worker_t) * workers);
+
+    if(! threads || ! list || pthread_mutex_init(&search.lock, NULL) != 0)
+    {
+        free(threads);
+        free(list);
+        return EXIT_FAILURE;
+    }
+
+    search.workers = workers;
+
+    /* A worker that did not start is done here */
+    for(size_t i = 0; i < workers; ++i)
+    {
+        list[i] = (_solver_worker_t) { .search = &search, .first = i, };
+
+        if(pthread_create(&threads[i], NULL, _solver_work, &list[i]) != 0)
+        {
+            threads[i] = pthread_self();
+            _solver_work(&list[i]);
+        }
+    }
+
+    for(size_t i = 0; i < workers; ++i)
+        if(! pthread_equal(threads[i], pthread_self()))
+            pthread_join(threads[i], NULL);
+
+    pthread_mutex_destroy(&search.lock);
+    free(threads);
+    free(list);
+#else
+    /* One worker, the same candidates */
+    _solver_worker_t worker = { .search = &search, .first = 0, };
+
+    (void) workers;
+    search.workers = 1;
+    _solver_work(&worker);
+#endif
+
+    if(search.best == SOLVER_TRIES)
+        return EXIT_FAILURE;
+
+    /* The winner's mines come with its seed */
+    grid->seed = _solver_seed(grid->seed, search.best);
+    rng_seed(&grid->rng, grid->seed);
+
+    return EXIT_SUCCESS;
+}
+
+/* Deletes the solver, frees up the memory.
+ *
+ *  solver  - object to be deleted
+ */
+void del_solver(solver_t *solver)
+{
+    if(solver == NULL)
+        return;
+
+    free(solver->known);
+    free(solver->queued);
+    free(solver->queue);
+    free(solver->safe);
+    free(solver->mines);
+    free(solver);
+}
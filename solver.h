@@ -0,0 +1,153 @@
+/*
+ *  solver.h
+ *
+ *  Finds tiles that are certainly safe or
+ *  certainly mines, using only what has been
+ *  revealed. Rules: a number whose mines are
+ *  all found (or whose unknown tiles must all
+ *  be mines), and pairs of close numbers whose
+ *  unknown tiles overlap (the 1-1 and 1-2
+ *  patterns).
+ *
+ *  The solver follows the grid's change log,
+ *  so an update looks only at the numbers
+ *  around the tiles changed since the last one.
+ *
+ */
+
+#ifndef _SAPER_SOLVER_H_FILE_
+#define _SAPER_SOLVER_H_FILE_
+
+/* Candidates tried for a board with no guess */
+#define SOLVER_TRIES                100000
+
+/* Workers of the generator are threads */
+#ifdef __linux__
+    #define SOLVER_PTHREAD
+#endif
+
+
+#include "grid.h"
+#include "rng.h"
+#include "tile.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef SOLVER_PTHREAD
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+
+/* What is known about a tile */
+typedef enum _sap_known_t
+{
+    UNKNOWN = 0,
+    SAFE,
+    MINED
+
+} known_t;
+
+/* A solver of one grid.
+ */
+typedef struct _sap_solver_t
+{
+    const grid_t *grid;                     /* The grid followed        */
+    uint8_t *known;                         /* known_t of each tile     */
+
+    size_t *queue;                          /* Numbers to look at       */
+    uint8_t *queued;                        /* Is the number queued     */
+    size_t queue_len;                       /* No. of queued numbers    */
+
+    size_t *safe;                           /* Safe tiles found         */
+    size_t safe_len;                        /* No. of safe tiles        */
+    size_t *mines;                          /* Mines found              */
+    size_t mines_len;                       /* No. of mines             */
+
+    size_t log_pos;                         /* Position in grid's log   */
+    bool fresh;                             /* Whole grid to be read    */
+
+} solver_t;
+
+
+/* Creates a solver following the grid.
+ *
+ *  grid    - the grid
+ *
+ *  Returns NULL if failed, valid pointer otherwise.
+ */
+solver_t    *new_solver(const grid_t *grid);
+
+/* Reads the grid's changes since the last
+ * update and finds what follows from them.
+ * The whole grid is read the first time,
+ * or if the log has a gap.
+ *
+ *  solver  - the solver
+ */
+void        solver_update(solver_t *solver);
+
+/* Gives a move certainly right: a safe tile
+ * to reveal or, if none, a mine to flag.
+ *
+ *  solver  - the solver (updated)
+ *  x, y    - the tile's position
+ *
+ * Returns SAFE or MINED, UNKNOWN if there is
+ * no such move.
+ */
+known_t     solver_hint(solver_t *solver, size_t *x, size_t *y);
+
+/* Gives what is known about a tile.
+ *
+ *  solver  - the solver (updated)
+ *  x, y    - the tile's position
+ */
+known_t     solver_known(const solver_t *solver, size_t x, size_t y);
+
+/* Plays a grid from a tile on with the
+ * solver's moves only.
+ *
+ *  grid    - the grid (changed)
+ *  x, y    - the first tile
+ *
+ * Returns true if the grid was won.
+ */
+bool        solver_solves(grid_t *grid, size_t x, size_t y);
+
+/* Chooses the seed of a deferred grid so
+ * that it is won without guessing when
+ * started at a given tile. Candidate 0 is
+ * grid->seed itself, candidate i has its
+ * own seed (grid->seed and i mixed), so a
+ * seed found plays the same board again.
+ * The workers try them side by side and the
+ * lowest solvable one is taken, whatever
+ * the number of workers (unless the time
+ * runs out first).
+ *
+ *  grid    - the grid (mines not placed)
+ *  x, y    - the first tile
+ *  workers - no. of workers, 0 for one per CPU
+ *  seconds - time limit, 0 for none
+ *
+ * Returns 0 if found (grid->seed is the new
+ * seed, the mines are placed by the first
+ * reveal), 1 if none of SOLVER_TRIES was
+ * or the time ran out.
+ */
+int         solver_no_guess(grid_t *grid, size_t x, size_t y, size_t workers, double seconds);
+
+/* Deletes the solver, frees up the memory.
+ *
+ *  solver  - object to be deleted
+ */
+void        del_solver(solver_t *solver);
+
+
+#endif /* _SAPER_SOLVER_H_FILE_ */
@@ -0,0 +1,222 @@
+/*
+ *  stats.c
+ *
+ *  Extends 'stats.h'.
+ *
+ */
+
+#include "stats.h"
+
+
+#define _STATS_OPENING              1       /* Label of empty tiles     */
+#define _STATS_DONE                 2       /* Opening revealed         */
+
+
+/* Groups of tiles (union-find), label 0 is none. */
+typedef struct _sap_stats_sets_t
+{
+    size_t *parent;
+    uint8_t *flags;
+    size_t count;
+    size_t cap;
+
+} _stats_sets_t;
+
+
+/* Root of the label's group. */
+static size_t _stats_find(_stats_sets_t *sets, size_t label)
+{
+    while(sets->parent[label] != label)
+    {
+        /* Halving the path on the way */
+        sets->parent[label] = sets->parent[sets->parent[label]];
+        label = sets->parent[label];
+    }
+
+    return label;
+}
+
+/* Joins two groups.
+ * Returns true if they were apart.
+ */
+static bool _stats_union(_stats_sets_t *sets, size_t a, size_t b)
+{
+    a = _stats_find(sets, a);
+    b = _stats_find(sets, b);
+
+    if(a == b)
+        return false;
+
+    sets->parent[b] = a;
+    sets->flags[a] |= sets->flags[b];
+
+    return true;
+}
+
+/* New group with given flags.
+ * Returns its label, 0 if failed.
+ */
+static size_t _stats_new(_stats_sets_t *sets, uint8_t flags)
+{
+    if(sets->count + 1 == sets->cap)
+    {
+        size_t *parent = (size_t *) realloc(sets->parent, sizeof(size_t) * sets->cap * 2);
+        if(! parent)
+            return 0;
+
+        sets->parent = parent;
+
+        uint8_t *temp = (uint8_t *) realloc(sets->flags, sets->cap * 2);
+        if(! temp)
+            return 0;
+
+        sets->flags = temp;
+        sets->cap *= 2;
+    }
+
+    const size_t label = ++sets->count;
+
+    sets->parent[label] = label;
+    sets->flags[label] = flags;
+
+    return label;
+}
+
+/* Checks if a number has no empty tile around. */
+static bool _stats_lone(const grid_t *grid, size_t x, size_t y)
+{
+    for(size_t sy = (y > 0 ? y - 1 : y); sy <= y + 1 && sy < grid->rows; ++sy)
+    {
+        const tile_t *row = grid_row(grid, sy);
+
+        for(size_t sx = (x > 0 ? x - 1 : x); sx <= x + 1 && sx < grid->cols; ++sx)
+            if(tile_lo(row[sx]) == D0)
+                return false;
+    }
+
+    return true;
+}
+
+
+/* Computes the metrics of a grid.
+ *
+ *  grid    - the grid (mines placed)
+ *  seconds - time the game took, 0 if unknown
+ *  stats   - the result
+ *
+ * Returns 0 if succeeded.
+ */
+int stats_compute(const grid_t *grid, double seconds, stats_t *stats)
+{
+    /* Pointer checking */
+    assert(grid && stats);
+
+    memset(stats, 0, sizeof(stats_t));
+
+    /* Nothing placed yet */
+    if(grid->pending)
+        return EXIT_SUCCESS;
+
+    const size_t cols = grid->cols;
+
+    /* Labels of the previous and current row */
+    size_t *labels = (size_t *) calloc(2 * cols, sizeof(size_t));
+    _stats_sets_t sets = { .cap = cols + 2, };
+
+    sets.parent = (size_t *) malloc(sizeof(size_t) * sets.cap);
+    sets.flags = (uint8_t *) malloc(sets.cap);
+
+    int status = (labels && sets.parent && sets.flags) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    size_t *prev = labels;
+    size_t *cur = labels + cols;
+
+    /* Groups made minus groups joined */
+    size_t groups[2] = {0, };
+
+    for(size_t y = 0; y < grid->rows && status == EXIT_SUCCESS; ++y)
+    {
+        const tile_t *row = grid_row(grid, y);
+
+        for(size_t x = 0; x < cols; ++x)
+        {
+            const lo_layer_t lo = tile_lo(row[x]);
+            cur[x] = 0;
+
+            /* Mines and numbers next to openings */
+            /* are no clicks of their own         */
+            if(lo == MINE || (lo != D0 && ! _stats_lone(grid, x, y)))
+                continue;
+
+            const bool opening = (lo == D0);
+            const bool revealed = (tile_up(row[x]) == REVEALED);
+
+            if(! opening)
+            {
+                ++stats->bbbv;
+                stats->bbbv_done += revealed;
+            }
+
+            /* Neighbours seen already: W, NW, N, NE */
+            /* (empty tiles never touch lone ones)   */
+            const size_t near[4] =
+            {
+                (x > 0) ? cur[x - 1] : 0,
+                (x > 0) ? prev[x - 1] : 0,
+                prev[x],
+                (x + 1 < cols) ? prev[x + 1] : 0
+            };
+
+            for(int k = 0; k < 4; ++k)
+            {
+                if(! near[k])
+                    continue;
+
+                if(! cur[x])
+                    cur[x] = near[k];
+
+                else if(_stats_union(&sets, cur[x], near[k]))
+                    --groups[opening];
+            }
+
+            if(! cur[x])
+            {
+                if(! (cur[x] = _stats_new(&sets, opening ? _STATS_OPENING : 0)))
+                {
+                    status = EXIT_FAILURE;
+                    break;
+                }
+
+                ++groups[opening];
+            }
+
+            if(opening && revealed)
+                sets.flags[_stats_find(&sets, cur[x])] |= _STATS_DONE;
+        }
+
+        size_t *temp = prev;
+        prev = cur;
+        cur = temp;
+    }
+
+    if(status == EXIT_SUCCESS)
+    {
+        stats->islands = groups[0];
+        stats->openings = groups[1];
+        stats->bbbv += groups[1];
+
+        /* Openings revealed, counted at their roots */
+        for(size_t l = 1; l <= sets.count; ++l)
+            if(sets.parent[l] == l && sets.flags[l] == (_STATS_OPENING | _STATS_DONE))
+                ++stats->bbbv_done;
+
+        if(seconds > 0)
+            stats->bbbv_s = (double) stats->bbbv_done / seconds;
+    }
+
+    free(labels);
+    free(sets.parent);
+    free(sets.flags);
+
+    return status;
+}
@@ -0,0 +1,53 @@
+/*
+ *  stats.h
+ *
+ *  Board difficulty metrics: 3BV (least
+ *  number of clicks needed to win), openings
+ *  and islands. All of them come from one
+ *  pass over the grid, row by row, joining
+ *  the groups of tiles with union-find.
+ *
+ */
+
+#ifndef _SAPER_STATS_H_FILE_
+#define _SAPER_STATS_H_FILE_
+
+#include "grid.h"
+#include "tile.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Metrics of a board.
+ * An opening is a group of connected empty
+ * tiles (one click each), an island a group
+ * of connected numbers with no empty tile
+ * around (each of its numbers is a click).
+ */
+typedef struct _sap_stats_t
+{
+    size_t bbbv;                            /* 3BV of the board         */
+    size_t bbbv_done;                       /* 3BV of what is revealed  */
+    size_t openings;                        /* No. of openings          */
+    size_t islands;                         /* No. of islands           */
+    double bbbv_s;                          /* 3BV per second           */
+
+} stats_t;
+
+
+/* Computes the metrics of a grid.
+ *
+ *  grid    - the grid (mines placed)
+ *  seconds - time the game took, 0 if unknown
+ *  stats   - the result
+ *
+ * Returns 0 if succeeded.
+ */
+int         stats_compute(const grid_t *grid, double seconds, stats_t *stats);
+
+
+#endif /* _SAPER_STATS_H_FILE_ */
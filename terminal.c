@@ -5,8 +5,106 @@
  * 
  */
 
+/* sigset_t and sigprocmask() under -std=c11 */
+#ifdef __linux__
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "terminal.h"
 
+#ifdef TERM_WINSIZE
+/* Set by the SIGWINCH handler */
+static volatile sig_atomic_t g_term_resized = 0;
+
+/* Notes a resize of the terminal. */
+static void _term_on_resize(int sig)
+{
+    (void) sig;
+    g_term_resized = 1;
+}
+#endif
+
+/* Set up by term_open() */
+static bool g_term_open = false;
+static bool g_term_alt = false;
+
+#ifdef TERM_RAW
+/* Settings of the input before term_open(), */
+/* and the raw ones                          */
+static struct termios g_term_saved;
+static struct termios g_term_set;
+static bool g_term_raw = false;
+
+/* Gives the terminal back: write() only, */
+/* so it is safe in a signal handler too   */
+static void _term_restore(void)
+{
+    if(g_term_raw)
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &g_term_saved);
+
+    if(g_term_alt)
+    {
+        const ssize_t n = write(STDOUT_FILENO, "\e[?1049l", 8);
+        (void) n;
+    }
+
+    g_term_raw = g_term_alt = g_term_open = false;
+}
+
+/* Gives the terminal back and dies as the */
+/* signal would have it                    */
+static void _term_on_signal(int sig)
+{
+    _term_restore();
+
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/* Gives the terminal back before stopping */
+/* (Ctrl+Z), sets it up again once resumed */
+/* and has everything drawn anew           */
+static void _term_on_stop(int sig)
+{
+    const int saved_errno = errno;
+    const bool raw = g_term_raw;
+    const bool alt = g_term_alt;
+
+    _term_restore();
+
+    /* Stopping here, until SIGCONT */
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, sig);
+
+    signal(sig, SIG_DFL);
+    sigprocmask(SIG_UNBLOCK, &set, NULL);
+    raise(sig);
+
+    signal(sig, _term_on_stop);
+
+    if(alt)
+    {
+        const ssize_t n = write(STDOUT_FILENO, "\e[?1049h", 8);
+        (void) n;
+    }
+
+    if(raw)
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &g_term_set);
+
+    g_term_raw = raw;
+    g_term_alt = alt;
+    g_term_open = true;
+
+#ifdef TERM_WINSIZE
+    /* The screen is blank, as after a resize */
+    g_term_resized = 1;
+#endif
+
+    errno = saved_errno;
+}
+#endif
+
 /* Moves the cursor in given direction.
  *
  *  dir         - the direction
@@ -23,9 +121,7 @@ void cur_move(dir_t dir, size_t x)
  */
 void cur_to(size_t x, size_t y)
 {
-    cur_home();
-    cur_move(DOWN, y);
-    cur_move(RIGHT, x);
+    fprintf(stdout, "\e[%zu;%zuH", y + 1, x + 1);
 }
 
 /* Saves current cursor position. 
@@ -61,8 +157,197 @@ void clr_line(void)
  */
 void cls(void)
 {
-    system(CMD_CLEAR);
-    cur_home();
+    fprintf(stdout, "\e[2J\e[H");
+}
+
+/* Sets the terminal up for the game: the
+ * alternate screen and raw input (no echo,
+ * keys read one by one), if it is one. Left
+ * as it was by term_close() or a signal.
+ *
+ * Returns true if the input is raw.
+ */
+bool term_open(void)
+{
+    if(g_term_open)
+        return term_raw();
+
+    g_term_open = true;
+
+    /* Own screen, the shell's comes back after */
+    if(isatty(STDOUT_FILENO))
+    {
+        fprintf(stdout, "\e[?1049h");
+        fflush(stdout);
+        g_term_alt = true;
+    }
+
+#ifdef TERM_RAW
+    if(! isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &g_term_saved) != 0)
+        return false;
+
+    /* Keys one by one, not echoed; Ctrl+C */
+    /* and Ctrl+Z still work                */
+    struct termios raw = g_term_saved;
+
+    raw.c_lflag &= (tcflag_t) ~(ICANON | ECHO | IEXTEN);
+    raw.c_iflag &= (tcflag_t) ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+
+    if(tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0)
+        return false;
+
+    g_term_set = raw;
+    g_term_raw = true;
+
+    signal(SIGINT, _term_on_signal);
+    signal(SIGTERM, _term_on_signal);
+    signal(SIGHUP, _term_on_signal);
+    signal(SIGTSTP, _term_on_stop);
+#endif
+
+    return term_raw();
+}
+
+/* Gives the terminal back as it was before
+ * term_open().
+ */
+void term_close(void)
+{
+    if(! g_term_open)
+        return;
+
+    /* What is left goes on the game's screen */
+    fflush(stdout);
+
+#ifdef TERM_RAW
+    _term_restore();
+#else
+    if(g_term_alt)
+    {
+        fprintf(stdout, "\e[?1049l");
+        fflush(stdout);
+    }
+
+    g_term_alt = g_term_open = false;
+#endif
+}
+
+/* Tells if the input is raw.
+ */
+bool term_raw(void)
+{
+#ifdef TERM_RAW
+    return g_term_raw;
+#else
+    return false;
+#endif
+}
+
+/* Reads a key, waiting at most timeout ms
+ * (-1 - until there is one).
+ *
+ *  timeout     - the wait (ms)
+ *
+ * Returns the character, TERM_KEY_ARROW + dir
+ * for the arrows, TERM_KEY_NONE if none came
+ * (timeout, a signal) or TERM_KEY_EOF.
+ */
+int term_key(int timeout)
+{
+#ifdef TERM_RAW
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+
+    /* Resizes break the wait too */
+    const int ready = poll(&pfd, 1, timeout);
+
+    if(ready == 0 || (ready < 0 && errno == EINTR))
+        return TERM_KEY_NONE;
+
+    unsigned char c;
+    const ssize_t n = (ready > 0) ? read(STDIN_FILENO, &c, 1) : -1;
+
+    if(n < 0 && errno == EINTR)
+        return TERM_KEY_NONE;
+
+    if(n <= 0)
+        return TERM_KEY_EOF;
+
+    if(c != '\e')
+        return c;
+
+    /* Arrows: ESC [ A... ESC [ D (or ESC O A...), */
+    /* in the order of dir_t                       */
+    unsigned char seq[2];
+
+    for(size_t i = 0; i < 2; ++i)
+        if(poll(&pfd, 1, TERM_ESC_WAIT_MS) <= 0 || read(STDIN_FILENO, &seq[i], 1) != 1)
+            return c;
+
+    if((seq[0] == '[' || seq[0] == 'O') && seq[1] >= 'A' && seq[1] <= 'D')
+        return TERM_KEY_ARROW + (seq[1] - 'A');
+
+    /* Other keys, not used */
+    return TERM_KEY_NONE;
+#else
+    (void) timeout;
+
+    const int c = fgetc(stdin);
+    return (c == EOF) ? TERM_KEY_EOF : c;
+#endif
+}
+
+/* Gives the size of the terminal.
+ *
+ *  cols, rows  - the size (characters)
+ *
+ * Returns false if not known.
+ */
+bool term_size(size_t *cols, size_t *rows)
+{
+    /* Pointer checking */
+    assert(cols && rows);
+
+#ifdef TERM_WINSIZE
+    struct winsize ws;
+
+    /* Not a terminal (a file, a pipe) */
+    if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 0)
+    {
+        *cols = ws.ws_col;
+        *rows = ws.ws_row;
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+/* Starts watching for the terminal's resizes
+ * (SIGWINCH).
+ */
+void term_watch(void)
+{
+#ifdef TERM_WINSIZE
+    signal(SIGWINCH, _term_on_resize);
+#endif
+}
+
+/* Tells if the terminal was resized since
+ * the last call.
+ */
+bool term_resized(void)
+{
+#ifdef TERM_WINSIZE
+    if(g_term_resized)
+    {
+        g_term_resized = 0;
+        return true;
+    }
+#endif
+
+    return false;
 }
 
 /* Sets text color. 
@@ -88,3 +373,201 @@ void col_write(const char *text, color_t color)
     fprintf(stdout, "%s", text);
     fprintf(stdout, "\e[%dm", (int) COLOR_DEFAULT);
 }
+
+/* Creates an empty frame.
+ *
+ *  Returns NULL if failed, valid pointer otherwise.
+ */
+frame_t *new_frame(void)
+{
+    frame_t *frame = (frame_t *) malloc(sizeof(frame_t));
+    if(! frame)
+        return NULL;
+
+    frame->data = (char *) malloc(FRAME_CAP);
+    if(! frame->data)
+    {
+        free(frame);
+        return NULL;
+    }
+
+    frame->len = 0;
+    frame->cap = FRAME_CAP;
+    frame->color = COLOR_DEFAULT;
+
+    return frame;
+}
+
+/* Adds bytes to the frame. If it cannot grow,
+ * what is there is written out first.
+ *
+ *  frame       - the frame
+ *  text        - the bytes
+ *  len         - no. of the bytes
+ */
+void frame_add(frame_t *frame, const char *text, size_t len)
+{
+    /* Pointer checking */
+    assert(frame && text);
+
+    while(len > 0)
+    {
+        if(frame->len == frame->cap)
+        {
+            char *temp = (char *) realloc(frame->data, 2 * frame->cap);
+
+            if(temp)
+            {
+                frame->data = temp;
+                frame->cap *= 2;
+            }
+
+            /* No memory, in parts then */
+            else if(frame_flush(frame) != EXIT_SUCCESS)
+                return;
+        }
+
+        const size_t part = (len < frame->cap - frame->len) ? len : frame->cap - frame->len;
+
+        memcpy(frame->data + frame->len, text, part);
+        frame->len += part;
+        text += part;
+        len -= part;
+    }
+}
+
+/* Adds a character to the frame.
+ *
+ *  frame       - the frame
+ *  c           - the character
+ */
+void frame_putc(frame_t *frame, char c)
+{
+    /* Pointer checking */
+    assert(frame);
+
+    if(frame->len < frame->cap)
+        frame->data[frame->len++] = c;
+    else
+        frame_add(frame, &c, 1);
+}
+
+/* Adds text to the frame.
+ *
+ *  frame       - the frame
+ *  text        - the text
+ */
+void frame_puts(frame_t *frame, const char *text)
+{
+    /* Pointer checking */
+    assert(frame && text);
+
+    frame_add(frame, text, strlen(text));
+}
+
+/* Adds a cursor move in given direction.
+ *
+ *  frame       - the frame
+ *  dir         - the direction
+ *  x           - no of characters (distance)
+ */
+void frame_move(frame_t *frame, dir_t dir, size_t x)
+{
+    char code[32];
+    const int len = snprintf(code, sizeof(code), "\e[%zu%c", x, 'A' + dir);
+
+    frame_add(frame, code, (size_t) len);
+}
+
+/* Adds a cursor move to given location.
+ *
+ *  frame       - the frame
+ *  x, y        - the location
+ */
+void frame_to(frame_t *frame, size_t x, size_t y)
+{
+    char code[48];
+    const int len = snprintf(code, sizeof(code), "\e[%zu;%zuH", y + 1, x + 1);
+
+    frame_add(frame, code, (size_t) len);
+}
+
+/* Adds clearing from the cursor to the end
+ * of the screen.
+ *
+ *  frame       - the frame
+ */
+void frame_erase(frame_t *frame)
+{
+    frame_add(frame, "\e[J", 3);
+}
+
+/* Sets text color, only if it changes.
+ *
+ *  frame       - the frame
+ *  color       - the color
+ */
+void frame_color(frame_t *frame, color_t color)
+{
+    /* Pointer checking */
+    assert(frame);
+
+    if(frame->color == color)
+        return;
+
+    char code[16];
+    const int len = snprintf(code, sizeof(code), "\e[%dm", (int) color);
+
+    frame_add(frame, code, (size_t) len);
+    frame->color = color;
+}
+
+/* Writes the frame out with one write()
+ * and empties it. Stdout is flushed first,
+ * so the order of output is kept.
+ *
+ *  frame       - the frame
+ *
+ * Returns 0 if succeeded.
+ */
+int frame_flush(frame_t *frame)
+{
+    /* Pointer checking */
+    assert(frame);
+
+    fflush(stdout);
+
+    /* One call, unless cut short */
+    size_t done = 0;
+
+    while(done < frame->len)
+    {
+        const ssize_t n = write(STDOUT_FILENO, frame->data + done, frame->len - done);
+        if(n < 0 && errno == EINTR)
+            continue;
+
+        if(n <= 0)
+        {
+            frame->len = 0;
+            return EXIT_FAILURE;
+        }
+
+        done += (size_t) n;
+    }
+
+    frame->len = 0;
+    return EXIT_SUCCESS;
+}
+
+/* Deletes the frame, frees up the memory.
+ *
+ *  frame       - object to be deleted
+ */
+void del_frame(frame_t *frame)
+{
+    if(! frame)
+        return;
+
+    free(frame->data);
+    free(frame);
+}
@@ -11,11 +11,7 @@
 #ifndef _SAPER_TERMINAL_H_FILE_
 #define _SAPER_TERMINAL_H_FILE_
 
-#ifdef __linux__
-    #define CMD_CLEAR       "clear"
-#elif _WIN32
-    #define CMD_CLEAR       "cls"
-#else
+#if ! defined(__linux__) && ! defined(_WIN32)
     #error "Unknown platform."
 #endif
 
@@ -49,10 +45,45 @@
     #define CHAR_SG_CORNER_RD       '+'  
 #endif
 
+/* Size of the terminal known, resizes signaled */
+#ifdef __linux__
+    #define TERM_WINSIZE
+#endif
+
+/* Raw input (termios), read with poll() */
+#ifdef __linux__
+    #define TERM_RAW
+#endif
+
+/* Keys of term_key(), besides characters */
+#define TERM_KEY_NONE               (-1)    /* Nothing (signal, timeout)    */
+#define TERM_KEY_EOF                (-2)    /* End of the input             */
+#define TERM_KEY_ARROW              0x100   /* Arrows, + dir_t              */
+
+/* Wait for the rest of an escape sequence (ms) */
+#define TERM_ESC_WAIT_MS            50
+
+/* First capacity of a frame (bytes) */
+#define FRAME_CAP                   4096
+
 #include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef TERM_WINSIZE
+    #include <sys/ioctl.h>
+#endif
+
+#ifdef TERM_RAW
+    #include <poll.h>
+    #include <termios.h>
+#endif
 
 /* Basic directions. */
 typedef enum _sap_dir_t
@@ -81,6 +112,19 @@ typedef enum _sap_color_t
 
 } color_t;
 
+/* Frame buffer. Output of a whole frame is
+ * put together here and written at once;
+ * colors are only set when they change.
+ */
+typedef struct _sap_frame_t
+{
+    char *data;                             /* The frame's bytes        */
+    size_t len;                             /* No. of bytes             */
+    size_t cap;                             /* Capacity of the buffer   */
+    color_t color;                          /* Current text color       */
+
+} frame_t;
+
 
 /* Moves the cursor in given direction.
  *
@@ -115,6 +159,53 @@ void    clr_line(void);
  */
 void    cls(void);
 
+/* Sets the terminal up for the game: the
+ * alternate screen and raw input (no echo,
+ * keys read one by one), if it is one. Left
+ * as it was by term_close() or a signal.
+ *
+ * Returns true if the input is raw.
+ */
+bool    term_open(void);
+
+/* Gives the terminal back as it was before
+ * term_open().
+ */
+void    term_close(void);
+
+/* Tells if the input is raw.
+ */
+bool    term_raw(void);
+
+/* Reads a key, waiting at most timeout ms
+ * (-1 - until there is one).
+ *
+ *  timeout     - the wait (ms)
+ *
+ * Returns the character, TERM_KEY_ARROW + dir
+ * for the arrows, TERM_KEY_NONE if none came
+ * (timeout, a signal) or TERM_KEY_EOF.
+ */
+int     term_key(int timeout);
+
+/* Gives the size of the terminal.
+ *
+ *  cols, rows  - the size (characters)
+ *
+ * Returns false if not known.
+ */
+bool    term_size(size_t *cols, size_t *rows);
+
+/* Starts watching for the terminal's resizes
+ * (SIGWINCH).
+ */
+void    term_watch(void);
+
+/* Tells if the terminal was resized since
+ * the last call.
+ */
+bool    term_resized(void);
+
 /* Sets text color. 
  *
  *  color       - the color
@@ -129,5 +220,79 @@ void    col_set(color_t color);
  */
 void    col_write(const char *text, color_t color);
 
+/* Creates an empty frame.
+ *
+ *  Returns NULL if failed, valid pointer otherwise.
+ */
+frame_t *new_frame(void);
+
+/* Adds bytes to the frame. If it cannot grow,
+ * what is there is written out first.
+ *
+ *  frame       - the frame
+ *  text        - the bytes
+ *  len         - no. of the bytes
+ */
+void    frame_add(frame_t *frame, const char *text, size_t len);
+
+/* Adds a character to the frame.
+ *
+ *  frame       - the frame
+ *  c           - the character
+ */
+void    frame_putc(frame_t *frame, char c);
+
+/* Adds text to the frame.
+ *
+ *  frame       - the frame
+ *  text        - the text
+ */
+void    frame_puts(frame_t *frame, const char *text);
+
+/* Adds a cursor move in given direction.
+ *
+ *  frame       - the frame
+ *  dir         - the direction
+ *  x           - no of characters (distance)
+ */
+void    frame_move(frame_t *frame, dir_t dir, size_t x);
+
+/* Adds a cursor move to given location.
+ *
+ *  frame       - the frame
+ *  x, y        - the location
+ */
+void    frame_to(frame_t *frame, size_t x, size_t y);
+
+/* Adds clearing from the cursor to the end
+ * of the screen.
+ *
+ *  frame       - the frame
+ */
+void    frame_erase(frame_t *frame);
+
+/* Sets text color, only if it changes.
+ *
+ *  frame       - the frame
+ *  color       - the color
+ */
+void    frame_color(frame_t *frame, color_t color);
+
+/* Writes the frame out with one write()
+ * and empties it. Stdout is flushed first,
+ * so the order of output is kept.
+ *
+ *  frame       - the frame
+ *
+ * Returns 0 if succeeded.
+ */
+int     frame_flush(frame_t *frame);
+
+/* Deletes the frame, frees up the memory.
+ *
+ *  frame       - object to be deleted
+ */
+void    del_frame(frame_t *frame);
+
 
 #endif /* _SAPER_TERMINAL_H_FILE_ */
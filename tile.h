@@ -1,52 +1,98 @@
-/*  
+/*
  *  tile.h
  *
  *  Tile is a single square placed on a grid.
- *  Each tile contains two layers, the upper 
- *  one decides if the tile has been revealed, 
+ *  Each tile contains two layers, the upper
+ *  one decides if the tile has been revealed,
  *  flagged or unrevealed.
  *  The lower one contains a 1-8 digit, a mine or
  *  is empty.
- * 
+ *
+ *  Both layers are packed into a single byte:
+ *  bits 0-3 hold the lower layer, bits 4-5
+ *  the upper one.
+ *
  */
 
 #ifndef _SAPER_TILE_H_FILE_
 #define _SAPER_TILE_H_FILE_
 
+#define TILE_LO_MASK                0x0F    /* Lower layer bits         */
+#define TILE_UP_MASK                0x30    /* Upper layer bits         */
+#define TILE_UP_SHIFT               4       /* Upper layer offset       */
+
+#include <stdint.h>
+
 
 /* Upper layer type */
 typedef enum _sap_upp_layer_t
 {
-    UNREVEALED = '#',                       /* Default, as '#'          */
-    REVEALED = ' ',                         /* Transparent              */
-    FLAG = 'F',                             /* As 'F', cannot be unrev  */
+    UNREVEALED = 0,                         /* Default, as '#'          */
+    REVEALED,                               /* Transparent              */
+    FLAG,                                   /* As 'F', cannot be unrev  */
 
 } up_layer_t;
 
 /* Lower layer type */
 typedef enum _sap_low_layer_t
 {
-    D0 = ' ',                               /* Empty                    */                                 
-    D1 = '1',                               /* As '1'                   */  
-    D2,                                     /* As '2' ...               */  
+    D0 = 0,                                 /* Empty                    */
+    D1,                                     /* As '1'                   */
+    D2,                                     /* As '2' ...               */
     D3,
     D4,
     D5,
     D6,
     D7,
     D8,                                     /* As '8'                   */
-    MINE = 'M'                              /* As '@'                   */
+    MINE                                    /* As 'M'                   */
 
 } lo_layer_t;
 
 
-/* A tile */
-typedef struct _sap_tile_t
+/* A tile (packed, see above) */
+typedef uint8_t tile_t;
+
+
+/* Gives the upper layer of the tile. */
+static inline up_layer_t tile_up(tile_t tile)
+{
+    return (up_layer_t) ((tile & TILE_UP_MASK) >> TILE_UP_SHIFT);
+}
+
+/* Gives the lower layer of the tile. */
+static inline lo_layer_t tile_lo(tile_t tile)
 {
-    up_layer_t up;                          /* Upper layer of the tile  */
-    lo_layer_t lo;                          /* Lower layer of the tile  */
+    return (lo_layer_t) (tile & TILE_LO_MASK);
+}
+
+/* Sets the upper layer of the tile. */
+static inline void tile_set_up(tile_t *tile, up_layer_t up)
+{
+    *tile = (tile_t) ((*tile & ~TILE_UP_MASK) | ((unsigned) up << TILE_UP_SHIFT));
+}
+
+/* Sets the lower layer of the tile. */
+static inline void tile_set_lo(tile_t *tile, lo_layer_t lo)
+{
+    *tile = (tile_t) ((*tile & ~TILE_LO_MASK) | (unsigned) lo);
+}
+
+/* Gives the character the tile is displayed as. */
+static inline char tile_char(tile_t tile)
+{
+    switch(tile_up(tile))
+    {
+        case REVEALED:
+            return " 12345678M"[tile_lo(tile)];
+
+        case FLAG:
+            return 'F';
 
-} tile_t;
+        default:
+            return '#';
+    }
+}
 
 
 #endif /*_SAPER_TILE_H_FILE_ */
\ No newline at end of file